@@ -1,18 +1,24 @@
-# OpenGL Rendering Tools
-# This is an "include" file for Qt .PRO files (using qmake)
-# Regardless of whether you use this or not, be sure and
-#define QT_IS_AVAILABLE
-
-#define OPENGL_ES (if using OpenGL ES 3, otherwise assumes OpenGL 4 on the desktop)
-
-HEADERS += $$PWD/include/GLBatch.h \
-           $$PWD/include/GLBatchBase.h \
-           $$PWD/include/GLShaderManager.h \
-           $$PWD/include/GLTools.h \
-           $$PWD/include/GLTriangleBatch.h \
-           $$PWD/include/GLFrameBuffer.h
-
-SOURCES += $$PWD/src/GLBatch.cpp \
-           $$PWD/src/GLShaderManager.cpp \
-           $$PWD/src/GLTriangleBatch.cpp \
-           $$PWD/src/GLTools.cpp
+# OpenGL Rendering Tools
+# This is an "include" file for Qt .PRO files (using qmake)
+# Regardless of whether you use this or not, be sure and
+#define QT_IS_AVAILABLE
+
+#define OPENGL_ES (if using OpenGL ES 3, otherwise assumes OpenGL 4 on the desktop)
+
+HEADERS += $$PWD/include/GLBatch.h \
+           $$PWD/include/GLBatchBase.h \
+           $$PWD/include/GLShaderManager.h \
+           $$PWD/include/GLTools.h \
+           $$PWD/include/GLTriangleBatch.h \
+           $$PWD/include/GLFrameBuffer.h \
+           $$PWD/include/GLAssetManager.h \
+           $$PWD/include/HalfFloat.h \
+           $$PWD/include/GLStateCache.h
+
+SOURCES += $$PWD/src/GLBatch.cpp \
+           $$PWD/src/GLShaderManager.cpp \
+           $$PWD/src/GLTriangleBatch.cpp \
+           $$PWD/src/GLTools.cpp \
+           $$PWD/src/GLAssetManager.cpp \
+           $$PWD/src/HalfFloat.cpp \
+           $$PWD/src/GLStateCache.cpp
@@ -0,0 +1,63 @@
+// Bench.h
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// A small set of timing programs for the library. They run headless on
+// EGL, with no window, so they can be run on a build machine. Each one
+// prints its own results, see BenchMain.cpp for how to pick them.
+
+#ifndef __GLT_BENCH
+#define __GLT_BENCH
+
+#include "GLTools.h"
+
+// Size of the framebuffer drawing benchmarks render into
+#define GLT_BENCH_WIDTH     256
+#define GLT_BENCH_HEIGHT    256
+
+typedef void (*GLTBENCHFUNC)(void);
+
+struct GLTBENCH {
+    const char      *szName;        // As given on the command line
+    bool            bNeedsGL;       // Context and framebuffer are made first
+    GLTBENCHFUNC    pFunc;
+    const char      *szDescription;
+    };
+
+// Milliseconds on a monotonic clock, only differences mean anything
+double BenchMilliseconds(void);
+
+// True if --all was given. Runs that would take minutes are skipped otherwise.
+extern bool bBenchAll;
+
+// The benchmarks
+void BenchWeld(void);
+void BenchWeldThreads(void);
+void BenchLayout(void);
+void BenchHalfFloat(void);
+void BenchUniformCalls(void);
+void BenchStartup(void);
+
+#endif
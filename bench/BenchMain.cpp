@@ -0,0 +1,168 @@
+// BenchMain.cpp
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Usage: gltbench [--all] [name ...]
+// With no names every benchmark is run, in the order of the table below.
+
+#include "Bench.h"
+
+#include <EGL/egl.h>
+#include <chrono>
+
+bool bBenchAll = false;
+
+static GLTBENCH benchmarks[] = {
+    { "weld",       false,  BenchWeld,      "AddTriangle, linear search vs spatial hash" },
+    { "weldthreads", false, BenchWeldThreads, "AddTriangles() weld time by thread count" },
+    { "layout",     true,   BenchLayout,    "End(), separate vertex buffers vs interleaved" },
+    { "half",       false,  BenchHalfFloat, "Half float conversion, old and new one at a time, and whole arrays" },
+    { "uniforms",   true,   BenchUniformCalls, "OpenGL calls made by UseStockShader()" },
+    { "startup",    true,   BenchStartup,   "InitializeStockShaders() time by compiler thread count" },
+    };
+
+static const int nBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+///////////////////////////////////////////////////////////////////////////////
+double BenchMilliseconds(void)
+    {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+// A core profile context with no surface at all (EGL_KHR_surfaceless_context),
+// and a framebuffer object to draw into instead of a window.
+static bool MakeContext(void)
+    {
+    static bool bDone = false;
+    static bool bGood = false;
+
+    if(bDone)
+        return bGood;
+
+    bDone = true;
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint nMajor, nMinor;
+    if(!eglInitialize(display, &nMajor, &nMinor))
+        {
+        fprintf(stderr, "Could not initialize EGL\n");
+        return false;
+        }
+
+    eglBindAPI(EGL_OPENGL_API);
+
+    EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = NULL;
+    EGLint nConfigs = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &nConfigs);
+
+    EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4,
+                                   EGL_CONTEXT_MINOR_VERSION, 1,
+                                   EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                   EGL_NONE };
+    EGLContext context = eglCreateContext(display, nConfigs ? config : NULL, EGL_NO_CONTEXT, contextAttributes);
+    if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+        fprintf(stderr, "Could not make an OpenGL 4.1 core context (EGL error 0x%x)\n", eglGetError());
+        return false;
+        }
+
+    GLuint fbo, colorBuffer, depthBuffer;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &colorBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, GLT_BENCH_WIDTH, GLT_BENCH_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, GLT_BENCH_WIDTH, GLT_BENCH_HEIGHT);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glViewport(0, 0, GLT_BENCH_WIDTH, GLT_BENCH_HEIGHT);
+
+    printf("OpenGL %s, %s\n\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+    bGood = true;
+    return true;
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+static bool Selected(int argc, char *argv[], const char *szName)
+    {
+    bool bAny = false;
+
+    for(int i = 1; i < argc; i++)
+        {
+        if(argv[i][0] == '-')
+            continue;
+
+        if(strcmp(argv[i], szName) == 0)
+            return true;
+
+        bAny = true;
+        }
+
+    return !bAny;
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+    {
+    for(int i = 1; i < argc; i++)
+        {
+        if(strcmp(argv[i], "--all") == 0)
+            bBenchAll = true;
+        else if(argv[i][0] == '-')
+            {
+            printf("Usage: %s [--all] [name ...]\n\n", argv[0]);
+            for(int b = 0; b < nBenchmarks; b++)
+                printf("  %-12s %s\n", benchmarks[b].szName, benchmarks[b].szDescription);
+            return 1;
+            }
+        }
+
+    int nRun = 0;
+    for(int b = 0; b < nBenchmarks; b++)
+        {
+        if(!Selected(argc, argv, benchmarks[b].szName))
+            continue;
+
+        if(benchmarks[b].bNeedsGL && !MakeContext())
+            return 1;
+
+        printf("== %s: %s\n", benchmarks[b].szName, benchmarks[b].szDescription);
+        benchmarks[b].pFunc();
+        printf("\n");
+        nRun++;
+        }
+
+    if(nRun == 0)
+        {
+        fprintf(stderr, "No benchmark by that name, try --help\n");
+        return 1;
+        }
+
+    return 0;
+    }
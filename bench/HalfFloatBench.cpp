@@ -0,0 +1,165 @@
+// HalfFloatBench.cpp
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Half float conversion speed, in millions of values per second. The
+// arrays are small enough to stay in cache, so this is the conversion
+// itself and not memory bandwidth. "original" is the branching version the
+// tables replaced, "table" is what convertFloatToHFloat() and
+// convertHFloatToFloat() do now, and "bulk" is the array functions.
+
+#include "Bench.h"
+#include "HalfFloat.h"
+#include "HalfFloatReference.h"
+
+#include <algorithm>
+#include <vector>
+
+#define HALF_BENCH_COUNT    4096
+#define HALF_BENCH_PASSES   4000
+
+// Keeps the compiler from throwing the scalar loops away
+static volatile unsigned int nHalfSink;
+
+///////////////////////////////////////////////////////////////////////////////
+// Fill with normal range values, values that mostly come out denormal, or
+// any bit pattern at all (Inf's and NaN's included)
+static void MakeFloats(std::vector<float> &floats, int nData)
+    {
+    unsigned int nSeed = 12345;
+    floats.resize(HALF_BENCH_COUNT);
+
+    for(size_t i = 0; i < floats.size(); i++)
+        {
+        nSeed = nSeed * 1664525 + 1013904223;
+        float f = (nSeed >> 8) / 16777216.0f;
+
+        if(nData == 0)
+            floats[i] = (f - 0.5f) * 2000.0f;
+        else if(nData == 1)
+            floats[i] = (f - 0.5f) * 1e-4f;
+        else
+            memcpy(&floats[i], &nSeed, sizeof(float));
+        }
+    }
+
+// The conversions as they were before they used tables. Called through a
+// pointer, the same as the library's, so neither gets inlined.
+static hfloat OriginalFloatToHFloat(float *f)
+    {
+    return referenceFloatToHFloat(f);
+    }
+
+static float OriginalHFloatToFloat(hfloat hf)
+    {
+    return referenceHFloatToFloat(hf);
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+static double ToHalfScalar(std::vector<float> &floats, std::vector<hfloat> &halfs, hfloat (*pConvert)(float *))
+    {
+    double fStart = BenchMilliseconds();
+    for(int p = 0; p < HALF_BENCH_PASSES; p++)
+        for(size_t i = 0; i < floats.size(); i++)
+            halfs[i] = pConvert(&floats[i]);
+    double fTime = BenchMilliseconds() - fStart;
+
+    nHalfSink = halfs[0];
+    return fTime;
+    }
+
+static double ToHalfBulk(std::vector<float> &floats, std::vector<hfloat> &halfs)
+    {
+    double fStart = BenchMilliseconds();
+    for(int p = 0; p < HALF_BENCH_PASSES; p++)
+        convertFloatToHFloatN(floats.data(), halfs.data(), floats.size());
+    double fTime = BenchMilliseconds() - fStart;
+
+    nHalfSink = halfs[0];
+    return fTime;
+    }
+
+static double ToFloatScalar(std::vector<hfloat> &halfs, std::vector<float> &floats, float (*pConvert)(hfloat))
+    {
+    double fStart = BenchMilliseconds();
+    for(int p = 0; p < HALF_BENCH_PASSES; p++)
+        for(size_t i = 0; i < halfs.size(); i++)
+            floats[i] = pConvert(halfs[i]);
+    double fTime = BenchMilliseconds() - fStart;
+
+    nHalfSink = (unsigned int)floats[0];
+    return fTime;
+    }
+
+static double ToFloatBulk(std::vector<hfloat> &halfs, std::vector<float> &floats)
+    {
+    double fStart = BenchMilliseconds();
+    for(int p = 0; p < HALF_BENCH_PASSES; p++)
+        convertHFloatToFloatN(halfs.data(), floats.data(), halfs.size());
+    double fTime = BenchMilliseconds() - fStart;
+
+    nHalfSink = (unsigned int)floats[0];
+    return fTime;
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+// In millions of values a second
+static double Rate(double fMilliseconds)
+    {
+    return (double)HALF_BENCH_COUNT * HALF_BENCH_PASSES / fMilliseconds / 1000.0;
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+// Best of three runs of each
+void BenchHalfFloat(void)
+    {
+    static const char *szData[3] = { "normal range", "denormal heavy", "any bits" };
+
+    printf("%16s %9s %14s %14s\n", "values", "", "float->half", "half->float");
+
+    for(int d = 0; d < 3; d++)
+        {
+        std::vector<float> floats, back(HALF_BENCH_COUNT);
+        std::vector<hfloat> halfs(HALF_BENCH_COUNT);
+        MakeFloats(floats, d);
+        convertFloatToHFloatN(floats.data(), halfs.data(), floats.size());
+
+        double fOriginalTo = 1e30, fOriginalFrom = 1e30;
+        double fScalarTo = 1e30, fScalarFrom = 1e30, fBulkTo = 1e30, fBulkFrom = 1e30;
+        for(int r = 0; r < 3; r++)
+            {
+            fOriginalTo = std::min(fOriginalTo, ToHalfScalar(floats, halfs, OriginalFloatToHFloat));
+            fScalarTo = std::min(fScalarTo, ToHalfScalar(floats, halfs, convertFloatToHFloat));
+            fBulkTo = std::min(fBulkTo, ToHalfBulk(floats, halfs));
+            fOriginalFrom = std::min(fOriginalFrom, ToFloatScalar(halfs, back, OriginalHFloatToFloat));
+            fScalarFrom = std::min(fScalarFrom, ToFloatScalar(halfs, back, convertHFloatToFloat));
+            fBulkFrom = std::min(fBulkFrom, ToFloatBulk(halfs, back));
+            }
+
+        printf("%16s %9s %14.0f %14.0f\n", szData[d], "original", Rate(fOriginalTo), Rate(fOriginalFrom));
+        printf("%16s %9s %14.0f %14.0f\n", "", "table", Rate(fScalarTo), Rate(fScalarFrom));
+        printf("%16s %9s %14.0f %14.0f\n", "", "bulk", Rate(fBulkTo), Rate(fBulkFrom));
+        }
+    }
@@ -0,0 +1,148 @@
+// LayoutBench.cpp
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// GLTriangleBatch::End() with the three separate vertex buffers against
+// GLT_BATCH_INTERLEAVED. Times the upload (End() until the driver is done
+// with it) and drawing. The mesh is drawn small, so the draws cost vertex
+// fetch and transform, not filling pixels. All three attributes are read
+// by the shader.
+
+#include "Bench.h"
+
+#include <algorithm>
+#include <vector>
+
+#define LAYOUT_GRID_SIDE    700         // 980,000 triangles
+#define LAYOUT_DRAWS        20
+
+///////////////////////////////////////////////////////////////////////////////
+static void BuildGrid(GLTriangleBatch &batch)
+    {
+    int nSide = LAYOUT_GRID_SIDE;
+    GLuint nVerts = (nSide + 1) * (nSide + 1);
+    std::vector<GLfloat> verts(nVerts * 3), norms(nVerts * 3), texCoords(nVerts * 2);
+    std::vector<GLuint> indexes;
+    indexes.reserve(nSide * nSide * 6);
+
+    for(int y = 0; y <= nSide; y++)
+        for(int x = 0; x <= nSide; x++)
+            {
+            int v = y * (nSide + 1) + x;
+            float s = (float)x / nSide;
+            float t = (float)y / nSide;
+            m3dLoadVector3(&verts[v * 3], s - 0.5f, t - 0.5f, 0.1f * sinf(s * 6.0f) * cosf(t * 6.0f));
+            m3dLoadVector3(&norms[v * 3], 0.0f, 0.0f, 1.0f);
+            m3dLoadVector2(&texCoords[v * 2], s, t);
+            }
+
+    for(int y = 0; y < nSide; y++)
+        for(int x = 0; x < nSide; x++)
+            {
+            GLuint v = y * (nSide + 1) + x;
+            GLuint quad[6] = { v, v + 1, v + nSide + 1, v + 1, v + nSide + 2, v + nSide + 1 };
+            indexes.insert(indexes.end(), quad, quad + 6);
+            }
+
+    batch.BeginMesh((GLuint)indexes.size());
+    batch.AddIndexedMesh(nVerts, (const M3DVector3f*)verts.data(), (const M3DVector3f*)norms.data(), (const M3DVector2f*)texCoords.data(),
+                         (GLuint)indexes.size(), indexes.data());
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+void BenchLayout(void)
+    {
+    GLShaderManager shaderManager;
+    if(!shaderManager.InitializeStockShaders())
+        {
+        printf("The stock shaders did not build\n");
+        return;
+        }
+
+    // The texture is only there so the texture coordinates get used
+    GLuint texture;
+    GLubyte texel[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glEnable(GL_DEPTH_TEST);
+
+    M3DMatrix44f mvMatrix = { 0.1f, 0.0f, 0.0f, 0.0f,
+                              0.0f, 0.1f, 0.0f, 0.0f,
+                              0.0f, 0.0f, 0.1f, 0.0f,
+                              0.0f, 0.0f, -2.0f, 1.0f };
+    M3DMatrix44f pMatrix = { 1.0f, 0.0f, 0.0f, 0.0f,
+                             0.0f, 1.0f, 0.0f, 0.0f,
+                             0.0f, 0.0f, -1.02f, -1.0f,
+                             0.0f, 0.0f, -0.2f, 0.0f };
+    M3DVector3f vLight = { 1.0f, 2.0f, 3.0f };
+    M3DVector4f vColor = { 0.8f, 0.6f, 0.4f, 1.0f };
+
+    static const char *szLayouts[2] = { "separate", "interleaved" };
+
+    printf("%12s %10s %12s %12s %14s\n", "layout", "triangles", "upload ms", "draw ms", "Mtriangles/s");
+
+    for(int l = 0; l < 2; l++)
+        {
+        double fUpload = 1e30, fDraw = 1e30;
+        GLuint nTriangles = 0;
+
+        for(int r = 0; r < 3; r++)
+            {
+            GLTriangleBatch batch;
+            BuildGrid(batch);
+            glFinish();
+
+            double fStart = BenchMilliseconds();
+            batch.End(l == 1 ? GLT_BATCH_INTERLEAVED : 0);
+            glFinish();
+            fUpload = std::min(fUpload, BenchMilliseconds() - fStart);
+            nTriangles = batch.GetIndexCount() / 3;
+
+            // One untimed draw, the first one can include driver setup
+            shaderManager.UseStockShader(GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF, mvMatrix, pMatrix, vLight, vColor, 0);
+            batch.Draw();
+            glFinish();
+
+            fStart = BenchMilliseconds();
+            for(int d = 0; d < LAYOUT_DRAWS; d++)
+                {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                batch.Draw();
+                }
+            glFinish();
+            fDraw = std::min(fDraw, (BenchMilliseconds() - fStart) / LAYOUT_DRAWS);
+            }
+
+        printf("%12s %10u %12.1f %12.2f %14.1f\n", szLayouts[l], nTriangles, fUpload, fDraw, nTriangles / fDraw / 1000.0);
+        }
+
+    if(glGetError() != GL_NO_ERROR)
+        printf("There were OpenGL errors\n");
+
+    glDisable(GL_DEPTH_TEST);
+    glDeleteTextures(1, &texture);
+    }
@@ -0,0 +1,101 @@
+// StartupBench.cpp
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// How long InitializeStockShaders() takes, with the driver allowed different
+// numbers of compiler threads (GL_KHR_parallel_shader_compile). One thread is
+// the same as compiling the shaders one after another. Turn off the driver's
+// own shader cache first, or every run after the first is a cache hit; on
+// Mesa that is MESA_SHADER_CACHE_DISABLE=true.
+
+#include "Bench.h"
+
+#include <EGL/egl.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#define STARTUP_BENCH_RUNS      9
+
+typedef void (APIENTRY *PFNMAXSHADERCOMPILERTHREADS)(GLuint nCount);
+
+///////////////////////////////////////////////////////////////////////////////
+// Median of a few runs, in milliseconds
+static double TimeStartup(void)
+    {
+    std::vector<double> times;
+
+    for(int r = 0; r < STARTUP_BENCH_RUNS; r++)
+        {
+        double fStart = BenchMilliseconds();
+        GLShaderManager shaderManager;
+        bool bGood = shaderManager.InitializeStockShaders();
+        glFinish();
+        times.push_back(BenchMilliseconds() - fStart);
+
+        if(!bGood)
+            {
+            printf("The stock shaders did not build\n");
+            return 0.0;
+            }
+        }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+void BenchStartup(void)
+    {
+    // The program binary cache would skip the compiles altogether
+    GLTools::GetGLTools()->gltSetProgramCacheDirectory(NULL);
+
+    PFNMAXSHADERCOMPILERTHREADS pMaxThreads = NULL;
+    GLint nExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &nExtensions);
+    for(GLint i = 0; i < nExtensions; i++)
+        {
+        const char *szExtension = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if(strcmp(szExtension, "GL_KHR_parallel_shader_compile") == 0)
+            pMaxThreads = (PFNMAXSHADERCOMPILERTHREADS)eglGetProcAddress("glMaxShaderCompilerThreadsKHR");
+        else if(strcmp(szExtension, "GL_ARB_parallel_shader_compile") == 0 && pMaxThreads == NULL)
+            pMaxThreads = (PFNMAXSHADERCOMPILERTHREADS)eglGetProcAddress("glMaxShaderCompilerThreadsARB");
+        }
+
+    printf("%u CPU(s), parallel shader compile %s\n", std::thread::hardware_concurrency(), pMaxThreads ? "available" : "not available");
+    printf("%18s %12s\n", "compiler threads", "median ms");
+
+    // The driver's default has to go first, there is no asking for it back
+    printf("%18s %12.2f\n", "driver default", TimeStartup());
+    if(pMaxThreads == NULL)
+        return;
+
+    static const GLuint threads[] = { 1, 2, 4, 8 };
+    for(int t = 0; t < 4; t++)
+        {
+        pMaxThreads(threads[t]);
+        printf("%18u %12.2f\n", threads[t], TimeStartup());
+        }
+    }
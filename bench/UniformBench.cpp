@@ -0,0 +1,155 @@
+// UniformBench.cpp
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// How many OpenGL calls UseStockShader() makes. The calls that matter are
+// defined here, count themselves, and pass on to the real ones in libGL.
+// Calls from the library go through these because it is linked into this
+// program. That only works when OpenGL isn't reached through Qt or GLEW
+// function pointers, which is how bench.pro builds it.
+
+#include "Bench.h"
+#include "GLStateCache.h"
+
+#include <dlfcn.h>
+
+enum { BENCH_CALL_LOOKUP = 0, BENCH_CALL_UNIFORM, BENCH_CALL_BUFFER, BENCH_CALL_PROGRAM, BENCH_CALL_LAST };
+
+static GLuint nBenchCalls[BENCH_CALL_LAST];
+
+// Find the real function the first time through, then count and call it
+#define BENCH_CALL(nKind, ret, name, params, args)                                  \
+    extern "C" ret APIENTRY name params                                             \
+        {                                                                           \
+        typedef ret (APIENTRY *PFUNC) params;                                       \
+        static PFUNC pReal = (PFUNC)dlsym(RTLD_NEXT, #name);                        \
+        nBenchCalls[nKind]++;                                                       \
+        return pReal args;                                                          \
+        }
+
+BENCH_CALL(BENCH_CALL_LOOKUP,  GLint, glGetUniformLocation, (GLuint program, const GLchar *name), (program, name))
+BENCH_CALL(BENCH_CALL_UNIFORM, void,  glUniform1i, (GLint location, GLint v0), (location, v0))
+BENCH_CALL(BENCH_CALL_UNIFORM, void,  glUniform3fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value))
+BENCH_CALL(BENCH_CALL_UNIFORM, void,  glUniform4fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value))
+BENCH_CALL(BENCH_CALL_UNIFORM, void,  glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value),
+           (location, count, transpose, value))
+BENCH_CALL(BENCH_CALL_BUFFER,  void,  glBindBuffer, (GLenum target, GLuint buffer), (target, buffer))
+BENCH_CALL(BENCH_CALL_BUFFER,  void,  glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size),
+           (target, index, buffer, offset, size))
+BENCH_CALL(BENCH_CALL_BUFFER,  void,  glBufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), (target, size, data, usage))
+BENCH_CALL(BENCH_CALL_BUFFER,  void,  glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data),
+           (target, offset, size, data))
+BENCH_CALL(BENCH_CALL_PROGRAM, void,  glUseProgram, (GLuint program), (program))
+
+#define UNIFORM_BENCH_CALLS     1000
+
+///////////////////////////////////////////////////////////////////////////////
+// The same call over and over, as a batch of draws with one shader would
+static void CallStockShader(GLShaderManager &shaderManager, int nShader)
+    {
+    M3DMatrix44f mMatrix = { 1.0f, 0.0f, 0.0f, 0.0f,
+                             0.0f, 1.0f, 0.0f, 0.0f,
+                             0.0f, 0.0f, 1.0f, 0.0f,
+                             0.0f, 0.0f, 0.0f, 1.0f };
+    M3DVector3f vLight = { 1.0f, 2.0f, 3.0f };
+    M3DVector4f vColor = { 0.8f, 0.6f, 0.4f, 1.0f };
+
+    switch(nShader)
+        {
+        case GLT_SHADER_IDENTITY:
+            shaderManager.UseStockShader(nShader, vColor);
+            break;
+        case GLT_SHADER_FLAT:
+            shaderManager.UseStockShader(nShader, mMatrix, vColor);
+            break;
+        case GLT_SHADER_SHADED:
+        case GLT_POINT_SPRITES_PLAIN:
+            shaderManager.UseStockShader(nShader, mMatrix);
+            break;
+        case GLT_SHADER_DEFAULT_LIGHT:
+            shaderManager.UseStockShader(nShader, mMatrix, mMatrix, vColor);
+            break;
+        case GLT_SHADER_POINT_LIGHT_DIFF:
+        case GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF:
+            shaderManager.UseStockShader(nShader, mMatrix, mMatrix, vLight, vColor, 0);
+            break;
+        case GLT_SHADER_TEXTURE_REPLACE:
+        case GLT_SHADER_POINT_SPRITES:
+            shaderManager.UseStockShader(nShader, mMatrix, 0);
+            break;
+        case GLT_SHADER_TEXTURE_MODULATE:
+            shaderManager.UseStockShader(nShader, mMatrix, vColor, 0);
+            break;
+        }
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+void BenchUniformCalls(void)
+    {
+    static const char *szShaders[] = { "IDENTITY", "FLAT", "SHADED", "DEFAULT_LIGHT", "POINT_LIGHT_DIFF", "TEXTURE_REPLACE",
+                                       "TEXTURE_MODULATE", "TEXTURE_POINT_LIGHT_DIFF", "POINT_SPRITES", "POINT_SPRITES_PLAIN" };
+
+    memset(nBenchCalls, 0, sizeof(nBenchCalls));
+    GLShaderManager shaderManager;
+    if(!shaderManager.InitializeStockShaders())
+        {
+        printf("The stock shaders did not build\n");
+        return;
+        }
+
+    printf("InitializeStockShaders: %u uniform lookups\n", nBenchCalls[BENCH_CALL_LOOKUP]);
+
+    // Without and with the state cache filtering repeated binds
+    GLStateCache *pStateCache = GLStateCache::GetStateCache();
+    for(int c = 0; c < 2; c++)
+        {
+        pStateCache->Enable(c == 1);
+
+        printf("\nCalls per UseStockShader(), %d in a row with the same shader, GLStateCache %s:\n",
+               UNIFORM_BENCH_CALLS, (c == 1) ? "on" : "off");
+        printf("%26s %8s %8s %8s %8s %8s\n", "shader", "lookup", "uniform", "buffer", "program", "total");
+
+        for(int s = 0; s <= GLT_POINT_SPRITES_PLAIN; s++)
+            {
+            // Once first, so building a lazy shader doesn't count
+            CallStockShader(shaderManager, s);
+            memset(nBenchCalls, 0, sizeof(nBenchCalls));
+
+            for(int i = 0; i < UNIFORM_BENCH_CALLS; i++)
+                CallStockShader(shaderManager, s);
+
+            GLuint nTotal = 0;
+            printf("%26s", szShaders[s]);
+            for(int k = 0; k < BENCH_CALL_LAST; k++)
+                {
+                printf(" %8.2f", (double)nBenchCalls[k] / UNIFORM_BENCH_CALLS);
+                nTotal += nBenchCalls[k];
+                }
+            printf(" %8.2f\n", (double)nTotal / UNIFORM_BENCH_CALLS);
+            }
+        }
+
+    pStateCache->Enable(false);
+    }
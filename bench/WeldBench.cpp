@@ -0,0 +1,186 @@
+// WeldBench.cpp
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// AddTriangle() welding with the old linear search against the spatial hash,
+// and AddTriangles() with the weld shared out over more and more threads.
+// The mesh is a curved grid, two triangles per square, so most vertices are
+// shared by six triangles the way they are in a CAD or terrain mesh.
+
+#include "Bench.h"
+
+#include <thread>
+#include <vector>
+
+struct BENCHTRIANGLE {
+    M3DVector3f vVerts[3];
+    M3DVector3f vNorms[3];
+    M3DVector2f vTexCoords[3];
+    };
+
+///////////////////////////////////////////////////////////////////////////////
+// About nTriangles triangles, it is rounded to a square grid
+static void MakeGrid(GLuint nTriangles, std::vector<BENCHTRIANGLE> &triangles)
+    {
+    int nSide = (int)sqrtf(nTriangles / 2.0f + 0.5f);
+    float fStep = 1.0f / nSide;
+
+    triangles.resize(nSide * nSide * 2);
+    BENCHTRIANGLE *pTriangle = triangles.data();
+
+    static const int corners[6][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+    for(int y = 0; y < nSide; y++)
+        for(int x = 0; x < nSide; x++)
+            for(int c = 0; c < 6; c++)
+                {
+                float s = (x + corners[c][0]) * fStep;
+                float t = (y + corners[c][1]) * fStep;
+                int v = c % 3;
+
+                m3dLoadVector3(pTriangle[c / 3].vVerts[v], s, t, 0.1f * sinf(s * 6.0f) * cosf(t * 6.0f));
+                m3dLoadVector3(pTriangle[c / 3].vNorms[v], 0.0f, 0.0f, 1.0f);
+                m3dLoadVector2(pTriangle[c / 3].vTexCoords[v], s, t);
+
+                if(c == 5)
+                    pTriangle += 2;
+                }
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+// Milliseconds to add every triangle, and the vertex count it welded down to
+static double TimeWeld(std::vector<BENCHTRIANGLE> &triangles, bool bHash, GLuint &nVerts)
+    {
+    GLTriangleBatch batch;
+    batch.SetWeldHash(bHash);
+    batch.BeginMesh((GLuint)triangles.size() * 3);
+
+    double fStart = BenchMilliseconds();
+    for(size_t i = 0; i < triangles.size(); i++)
+        batch.AddTriangle(triangles[i].vVerts, triangles[i].vNorms, triangles[i].vTexCoords);
+    double fTime = BenchMilliseconds() - fStart;
+
+    nVerts = batch.GetVertexCount();
+    return fTime;
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+void BenchWeld(void)
+    {
+    static const GLuint sizes[] = { 10000, 100000, 1000000 };
+
+    printf("%10s %10s %14s %14s %10s\n", "triangles", "vertices", "search ms", "hash ms", "speedup");
+
+    for(int i = 0; i < 3; i++)
+        {
+        std::vector<BENCHTRIANGLE> triangles;
+        MakeGrid(sizes[i], triangles);
+
+        GLuint nHashVerts, nSearchVerts = 0;
+        double fHash = TimeWeld(triangles, true, nHashVerts);
+
+        // The search is O(n^2), a million triangles take many minutes
+        if(sizes[i] > 100000 && !bBenchAll)
+            {
+            printf("%10zu %10u %14s %14.1f %10s\n", triangles.size(), nHashVerts, "(--all)", fHash, "");
+            continue;
+            }
+
+        double fSearch = TimeWeld(triangles, false, nSearchVerts);
+        printf("%10zu %10u %14.1f %14.1f %9.0fx\n", triangles.size(), nHashVerts, fSearch, fHash, fSearch / fHash);
+
+        if(nSearchVerts != nHashVerts)
+            printf("MISMATCH: the search welded to %u vertices\n", nSearchVerts);
+        }
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+// Milliseconds for AddTriangles() to weld everything on nThreads threads,
+// best of three, and the vertex count it welded down to
+static double TimeWeldThreads(GLuint nTriangles, const M3DVector3f *pVerts, const M3DVector3f *pNorms,
+                              const M3DVector2f *pTexCoords, GLuint nThreads, GLuint &nVerts)
+    {
+    double fBest = 0.0;
+
+    for(int nRun = 0; nRun < 3; nRun++)
+        {
+        GLTriangleBatch batch;
+        batch.SetWeldThreads(nThreads);
+        batch.BeginMesh(nTriangles * 3);
+
+        double fStart = BenchMilliseconds();
+        batch.AddTriangles(nTriangles, pVerts, pNorms, pTexCoords);
+        double fTime = BenchMilliseconds() - fStart;
+
+        if(nRun == 0 || fTime < fBest)
+            fBest = fTime;
+
+        nVerts = batch.GetVertexCount();
+        }
+
+    return fBest;
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+void BenchWeldThreads(void)
+    {
+    static const GLuint threads[] = { 1, 2, 4, 8 };
+
+    std::vector<BENCHTRIANGLE> triangles;
+    MakeGrid(1000000, triangles);
+
+    // AddTriangles() wants each attribute in its own array
+    GLuint nTriangles = (GLuint)triangles.size();
+    std::vector<M3DVector3f> verts(nTriangles * 3), norms(nTriangles * 3);
+    std::vector<M3DVector2f> texCoords(nTriangles * 3);
+    for(GLuint t = 0; t < nTriangles; t++)
+        for(int v = 0; v < 3; v++)
+            {
+            memcpy(verts[t * 3 + v], triangles[t].vVerts[v], sizeof(M3DVector3f));
+            memcpy(norms[t * 3 + v], triangles[t].vNorms[v], sizeof(M3DVector3f));
+            memcpy(texCoords[t * 3 + v], triangles[t].vTexCoords[v], sizeof(M3DVector2f));
+            }
+
+    printf("%u triangles, %u cores\n", nTriangles, std::thread::hardware_concurrency());
+    printf("%10s %10s %14s %10s\n", "threads", "vertices", "ms", "speedup");
+
+    GLuint nSerialVerts = 0;
+    double fSerial = 0.0;
+    for(int i = 0; i < 4; i++)
+        {
+        GLuint nVerts;
+        double fTime = TimeWeldThreads(nTriangles, verts.data(), norms.data(), texCoords.data(), threads[i], nVerts);
+        if(i == 0)
+            {
+            fSerial = fTime;
+            nSerialVerts = nVerts;
+            }
+
+        printf("%10u %10u %14.1f %9.2fx\n", threads[i], nVerts, fTime, fSerial / fTime);
+
+        if(nVerts != nSerialVerts)
+            printf("MISMATCH: the serial weld gave %u vertices\n", nSerialVerts);
+        }
+    }
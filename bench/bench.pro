@@ -0,0 +1,28 @@
+# GLTools benchmarks
+# A console program that runs headless on EGL (Linux, or anything else with
+# Mesa or a vendor EGL). Build with qmake and run ./gltbench --help for the list.
+#
+# This does not use Qt for OpenGL, so QT_IS_AVAILABLE is left undefined and
+# BenchGL.h supplies the OpenGL declarations. math3d.h has to be on the include
+# path, the same as for any other program using GLTools.
+
+TEMPLATE = app
+TARGET = gltbench
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+include(../GLTools.pri)
+
+INCLUDEPATH += $$PWD/../include $$PWD/../tools
+QMAKE_CXXFLAGS += -include $$PWD/BenchGL.h
+LIBS += -lEGL -lGL -lpthread -ldl
+
+HEADERS += Bench.h \
+           BenchGL.h
+
+SOURCES += BenchMain.cpp \
+           WeldBench.cpp \
+           LayoutBench.cpp \
+           HalfFloatBench.cpp \
+           UniformBench.cpp \
+           StartupBench.cpp
@@ -0,0 +1,128 @@
+// GLAssetManager.h
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list 
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
+to endorse or promote products derived from this software without specific prior 
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ *  Loads meshes in the background. Files are read on worker threads, highest
+ *  priority first, and the uploads are handed back to the GL thread which does
+ *  them a chunk at a time in Update(), so no one frame takes the whole hit.
+ *  Meshes read but not yet uploaded are held to a memory budget.
+ */
+
+#ifndef __GLT_ASSET_MANAGER
+#define __GLT_ASSET_MANAGER
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <queue>
+#include <map>
+#include <string>
+
+#include "GLTriangleBatch.h"
+
+#define GLT_ASSET_MEMORY_BUDGET     (256 * 1024 * 1024)     // Bytes read but not uploaded yet
+#define GLT_ASSET_UPLOAD_CHUNK      (256 * 1024)            // Bytes per glBufferSubData()
+
+enum GLT_ASSET_STATUS { GLT_ASSET_INVALID = 0, GLT_ASSET_QUEUED, GLT_ASSET_READING, GLT_ASSET_UPLOADING,
+                        GLT_ASSET_READY, GLT_ASSET_FAILED };
+
+// Called from Update() on the GL thread when an asset is ready, or has failed
+typedef void (*GLT_ASSET_CALLBACK)(GLuint nAsset, GLT_ASSET_STATUS status, void *pUserData);
+
+class GLAssetManager
+    {
+    public:
+        // nThreads of 0 is one per core
+        GLAssetManager(GLuint nThreads = 1, size_t nMemoryBudget = GLT_ASSET_MEMORY_BUDGET);
+        ~GLAssetManager(void);     // On the GL thread, if Update() has ever been called
+
+        // Queue a mesh file to be loaded into pBatch. Higher priorities go first.
+        // Returns an id for GetStatus(), the batch must stay around until it's done.
+        GLuint LoadMesh(GLTriangleBatch *pBatch, const char *szFileName, int nPriority = 0,
+                        GLT_ASSET_CALLBACK pCallback = nullptr, void *pUserData = nullptr,
+                        bool bNormals = true, bool bTexCoords = true);
+
+        // Call once a frame on the GL thread. Uploads for no more than (about)
+        // dMilliseconds, but always makes some progress.
+        void Update(double dMilliseconds);
+
+        // READY and FAILED are only reported once, after that the id is
+        // forgotten and it's GLT_ASSET_INVALID. Assets loaded with a callback
+        // are forgotten as soon as the callback has been told.
+        GLT_ASSET_STATUS GetStatus(GLuint nAsset);
+        GLuint GetPendingCount(void);               // Not READY or FAILED yet
+        size_t GetMemoryInUse(void);
+
+        inline void SetUploadChunk(size_t nBytes) { nUploadChunk = (nBytes > 0) ? nBytes : GLT_ASSET_UPLOAD_CHUNK; }
+
+    protected:
+        struct ASSET {
+            GLuint  nID;
+            int     nPriority;
+            GLTriangleBatch *pBatch;
+            std::string fileName;
+            bool    bNormals;
+            bool    bTexCoords;
+            GLT_ASSET_CALLBACK pCallback;
+            void    *pUserData;
+            bool    bOK;
+            size_t  nMemory;            // Counted against the budget
+            GLTMESHDATA data;
+            };
+
+        // Highest priority first, then first come first served
+        struct ASSETORDER {
+            bool operator()(const ASSET *pA, const ASSET *pB) const
+                {
+                if(pA->nPriority != pB->nPriority)
+                    return pA->nPriority < pB->nPriority;
+                return pA->nID > pB->nID;
+                }
+            };
+
+        typedef std::priority_queue<ASSET*, std::vector<ASSET*>, ASSETORDER> ASSETQUEUE;
+
+        void ReadThread(void);
+        void Finish(ASSET *pAsset, GLT_ASSET_STATUS status);
+
+        std::vector<std::thread> threads;
+        std::mutex              assetMutex;
+        std::condition_variable workReady;     // Something to read, or time to quit
+        std::condition_variable memoryFreed;   // Something was uploaded, or time to quit
+
+        ASSETQUEUE  readQueue;          // Waiting to be read
+        ASSETQUEUE  uploadQueue;        // Read, waiting for the GL thread
+        ASSET       *pUploading;        // Part way through uploading, GL thread only
+        std::map<GLuint, GLT_ASSET_STATUS> statusTable;
+
+        GLuint  nNextID;
+        GLuint  nPending;
+        size_t  nMemoryBudget;
+        size_t  nMemoryInUse;
+        size_t  nUploadChunk;
+        bool    bQuit;
+    };
+
+#endif
@@ -1,128 +1,145 @@
-/*
-GLBatch.h
- 
-Copyright (c) 2009-2023, Richard S. Wright Jr.
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without modification, 
-are permitted provided that the following conditions are met:
-
-Redistributions of source code must retain the above copyright notice, this list 
-of conditions and the following disclaimer.
-
-Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
-to endorse or promote products derived from this software without specific prior 
-written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
-EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
-OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
-SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
-INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
-TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
-BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
-CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
-ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#ifndef __GL_BATCH__
-#define __GL_BATCH__
-
-#include <assert.h>
-
-#ifdef __APPLE__
-#include <TargetConditionals.h>
-#if TARGET_OS_IPHONE | TARGET_IPHONE_SIMULATOR
-#include <OpenGLES/ES3/gl.h>
-#define OPENGL_ES
-#else
-#include <GL/glew.h>
-#include <OpenGL/gl.h>		// Apple OpenGL haders (version depends on OS X SDK version)
-#endif
-
-#endif
-#include "math3d.h"
-#include "GLBatchBase.h"
-#include "M3DGeometryTransform.h"
-#include "M3DFrame.h"
-#include "M3DFrustum.h"
-#include "GLShaderManager.h"
-
-class GLBatch: public GLBatchBase
-    {
-    public:
-        GLBatch(void);
-        virtual ~GLBatch(void);
-        
-		// Start populating the array
-        void Begin(GLenum primitive, GLuint nVerts);
-        void Reset(GLenum primitive);
-        inline int NumCurrentVerts(void) { return nVertsBuilding; }
-        inline bool IsBatchDone(void) { return bBatchDone; }
-        inline GLenum GetPrimitive(void) { return primitiveType; }
-        
-        
-        // Tell the batch you are done
-        void End(void);
-
-        // Block Copy in vertex data
-        void CopyVertexData3f(M3DVector3f *vVerts);
-        void CopyNormalDataf(M3DVector3f *vNorms);
-        void CopyColorData4f(M3DVector4f *vColors);
-        void CopyTexCoordData2f(M3DVector2f *vTexCoords);
-
-        // Just to make life easier...
-        inline void CopyVertexData3f(GLfloat *vVerts) { CopyVertexData3f((M3DVector3f *)vVerts); }
-        inline void CopyNormalDataf(GLfloat *vNorms) { CopyNormalDataf((M3DVector3f *)vNorms); }
-        inline void CopyColorData4f(GLfloat *vColors) { CopyColorData4f((M3DVector4f *)vColors); }
-        inline void CopyTexCoordData2f(GLfloat *vTex) { CopyTexCoordData2f((M3DVector2f *)vTex); }
-
-        virtual void Draw(void);
- 
-        void Vertex3f(GLfloat x, GLfloat y, GLfloat z);
-        void Vertex3fv(M3DVector3f vVertex);
-        
-        void Normal3f(GLfloat x, GLfloat y, GLfloat z);
-        void Normal3fv(M3DVector3f vNormal);
-        
-        void Color4f(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
-        void Color4fv(M3DVector4f vColor);
-        
-        void TexCoord2f(GLclampf s, GLclampf t);
-        void TexCoord2fv(M3DVector2f vTexCoord);
-
-        void MapForUpdate(void);
-        void UnmapForUpdate(void);
-        inline M3DVector3f* GetVertex3f(int iIndex) { return &(pVerts[iIndex]);}
-        void UpdateVert(uint index, M3DVector3f vVertex);
-
-        inline M3DVector4f* GetColor4f(int iIndex) { return &(pColors[iIndex]); }
-        void UpdateColor(uint index, M3DVector4f vColor);
-
-        inline M3DVector3f* GetNormal3f(int iIndex) { return &(pNormals[iIndex]); }
-        void UpdateNormal(uint index, M3DVector3f vNormal);
-
-        inline M3DVector2f* GetTexCoord2f(int iIndex) { return &(pTexCoords[iIndex]); }
-        void UpdateTexCoord(uint index, M3DVector2f vTexCoord);
-        
-    protected:
-        GLenum		primitiveType;		// What am I drawing....
-        GLuint      uiVertexArrayObject;
-        GLuint		uiVertexArray;
-        GLuint      uiNormalArray;
-        GLuint		uiColorArray;
-        GLuint		uiTextureCoordArray;
-        
-        GLuint nVertsBuilding;		// Building up vertexes counter (immediate mode emulator)
-        GLuint nNumVerts;			// Number of verticies in this batch
-		
-        bool	bBatchDone = false;			// Batch has been built
-        bool    bBuffersMade = false;       // Buffers have been allocated
-	
-        M3DVector3f *pVerts = nullptr;
-        M3DVector3f *pNormals = nullptr;
-        M3DVector4f *pColors = nullptr;
-        M3DVector2f *pTexCoords = nullptr;
-        };
-
-#endif // __GL_BATCH__
+/*
+GLBatch.h
+ 
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list 
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
+to endorse or promote products derived from this software without specific prior 
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __GL_BATCH__
+#define __GL_BATCH__
+
+#include <assert.h>
+
+#ifdef __APPLE__
+#include <TargetConditionals.h>
+#if TARGET_OS_IPHONE | TARGET_IPHONE_SIMULATOR
+#include <OpenGLES/ES3/gl.h>
+#define OPENGL_ES
+#else
+#include <GL/glew.h>
+#include <OpenGL/gl.h>		// Apple OpenGL haders (version depends on OS X SDK version)
+#endif
+
+#endif
+#include "math3d.h"
+#include "GLBatchBase.h"
+#include "M3DGeometryTransform.h"
+#include "M3DFrame.h"
+#include "M3DFrustum.h"
+#include "GLShaderManager.h"
+#include "HalfFloat.h"
+
+// Attributes that can be stored as half floats, or'ed together for GLBatch::Begin()
+#define GLT_BATCH_HALF_COLORS       (1 << GLT_ATTRIBUTE_COLOR)
+#define GLT_BATCH_HALF_NORMALS      (1 << GLT_ATTRIBUTE_NORMAL)
+#define GLT_BATCH_HALF_TEXCOORDS    (1 << GLT_ATTRIBUTE_TEXTURE0)
+
+class GLBatch: public GLBatchBase
+    {
+    public:
+        GLBatch(void);
+        virtual ~GLBatch(void);
+        
+		// Start populating the array. Colors, normals, and texture coordinates can be
+        // stored as half floats (GLT_BATCH_HALF_ flags), which halves what is uploaded.
+        // Everything is still passed in as floats, it's converted on the way to the GPU.
+        void Begin(GLenum primitive, GLuint nVerts, GLuint nHalfFloats = 0);
+        void Reset(GLenum primitive);
+        inline int NumCurrentVerts(void) { return nVertsBuilding; }
+        inline bool IsBatchDone(void) { return bBatchDone; }
+        inline GLenum GetPrimitive(void) { return primitiveType; }
+        
+        
+        // Tell the batch you are done
+        void End(void);
+
+        // Block Copy in vertex data
+        void CopyVertexData3f(M3DVector3f *vVerts);
+        void CopyNormalDataf(M3DVector3f *vNorms);
+        void CopyColorData4f(M3DVector4f *vColors);
+        void CopyTexCoordData2f(M3DVector2f *vTexCoords);
+
+        // Just to make life easier...
+        inline void CopyVertexData3f(GLfloat *vVerts) { CopyVertexData3f((M3DVector3f *)vVerts); }
+        inline void CopyNormalDataf(GLfloat *vNorms) { CopyNormalDataf((M3DVector3f *)vNorms); }
+        inline void CopyColorData4f(GLfloat *vColors) { CopyColorData4f((M3DVector4f *)vColors); }
+        inline void CopyTexCoordData2f(GLfloat *vTex) { CopyTexCoordData2f((M3DVector2f *)vTex); }
+
+        virtual void Draw(void);
+ 
+        void Vertex3f(GLfloat x, GLfloat y, GLfloat z);
+        void Vertex3fv(M3DVector3f vVertex);
+        
+        void Normal3f(GLfloat x, GLfloat y, GLfloat z);
+        void Normal3fv(M3DVector3f vNormal);
+        
+        void Color4f(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+        void Color4fv(M3DVector4f vColor);
+        
+        void TexCoord2f(GLclampf s, GLclampf t);
+        void TexCoord2fv(M3DVector2f vTexCoord);
+
+        void MapForUpdate(void);
+        void UnmapForUpdate(void);
+        inline M3DVector3f* GetVertex3f(int iIndex) { return &(pVerts[iIndex]);}
+        void UpdateVert(uint index, M3DVector3f vVertex);
+
+        // The Get functions return NULL for half float attributes, use Update
+        inline M3DVector4f* GetColor4f(int iIndex) { return (nHalfFloats & GLT_BATCH_HALF_COLORS) ? nullptr : &(pColors[iIndex]); }
+        void UpdateColor(uint index, M3DVector4f vColor);
+
+        inline M3DVector3f* GetNormal3f(int iIndex) { return (nHalfFloats & GLT_BATCH_HALF_NORMALS) ? nullptr : &(pNormals[iIndex]); }
+        void UpdateNormal(uint index, M3DVector3f vNormal);
+
+        inline M3DVector2f* GetTexCoord2f(int iIndex) { return (nHalfFloats & GLT_BATCH_HALF_TEXCOORDS) ? nullptr : &(pTexCoords[iIndex]); }
+        void UpdateTexCoord(uint index, M3DVector2f vTexCoord);
+        
+    protected:
+        void CreateAttribute(GLuint *pBuffer, GLuint iAttribute, GLint nComponents);
+        void DeleteAttribute(GLuint *pBuffer);
+        void BufferAttribute(GLuint buffer, GLuint iAttribute, GLint nComponents, const GLfloat *pData);
+        void UpdateAttribute(void *pMapped, GLuint iAttribute, GLint nComponents, uint index, const GLfloat *pData);
+        inline GLuint AttributeSize(GLuint iAttribute, GLint nComponents)
+            { return nComponents * ((nHalfFloats & (1 << iAttribute)) ? sizeof(hfloat) : sizeof(GLfloat)); }
+
+        GLenum		primitiveType;		// What am I drawing....
+        GLuint      uiVertexArrayObject;
+        GLuint		uiVertexArray;
+        GLuint      uiNormalArray;
+        GLuint		uiColorArray;
+        GLuint		uiTextureCoordArray;
+        
+        GLuint nVertsBuilding;		// Building up vertexes counter (immediate mode emulator)
+        GLuint nNumVerts;			// Number of verticies in this batch
+        GLuint nHalfFloats = 0;     // GLT_BATCH_HALF_ flags
+		
+        bool	bBatchDone = false;			// Batch has been built
+        bool    bBuffersMade = false;       // Buffers have been allocated
+	
+        M3DVector3f *pVerts = nullptr;
+        M3DVector3f *pNormals = nullptr;
+        M3DVector4f *pColors = nullptr;
+        M3DVector2f *pTexCoords = nullptr;
+        };
+
+#endif // __GL_BATCH__
@@ -1,102 +1,422 @@
-// GLShaderManager.h
-/*
-Copyright (c) 2009-2023, Richard S. Wright Jr.
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without modification, 
-are permitted provided that the following conditions are met:
-
-Redistributions of source code must retain the above copyright notice, this list 
-of conditions and the following disclaimer.
-
-Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
-to endorse or promote products derived from this software without specific prior 
-written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
-EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
-OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
-SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
-INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
-TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
-BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
-CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
-ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#ifndef __GLT_SHADER_MANAGER
-#define __GLT_SHADER_MANAGER
-
-#ifdef QT_IS_AVAILABLE
-#include <QOpenGLExtraFunctions>
-#endif
-
-#ifdef __APPLE__
-#include <TargetConditionals.h>
-#if TARGET_OS_IPHONE | TARGET_IPHONE_SIMULATOR
-#include <OpenGLES/ES3/gl.h>
-#define OPENGL_ES
-#else
-#include <GL/glew.h>
-#include <OpenGL/gl.h>		// Apple OpenGL haders (version depends on OS X SDK version)
-#endif
-#endif
-
-#include <stdarg.h>
-#include <string.h>
-
-// Maximum length of shader name
-#define MAX_SHADER_NAME_LENGTH	64
-
-enum GLT_STOCK_SHADER { GLT_SHADER_IDENTITY = 0, GLT_SHADER_FLAT, GLT_SHADER_SHADED, GLT_SHADER_DEFAULT_LIGHT, GLT_SHADER_POINT_LIGHT_DIFF, GLT_SHADER_TEXTURE_REPLACE, GLT_SHADER_TEXTURE_MODULATE, GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF,
-                                GLT_SHADER_POINT_SPRITES, GLT_POINT_SPRITES_PLAIN, GLT_SHADER_LAST };
-
-
-enum GLT_SHADER_ATTRIBUTE { GLT_ATTRIBUTE_VERTEX = 0, GLT_ATTRIBUTE_COLOR, GLT_ATTRIBUTE_NORMAL, 
-                                    GLT_ATTRIBUTE_TEXTURE0, GLT_ATTRIBUTE_TEXTURE1, GLT_ATTRIBUTE_TEXTURE2, GLT_ATTRIBUTE_TEXTURE3,
-                                    GLT_ATTRIBUTE_LAST};
-
-
-struct SHADERLOOKUPENTRY {
-	char szVertexShaderName[MAX_SHADER_NAME_LENGTH];
-	char szFragShaderName[MAX_SHADER_NAME_LENGTH];
-	GLuint uiShaderID;
-	};
-
-#ifdef QT_IS_AVAILABLE
-    class GLShaderManager: protected QOpenGLExtraFunctions
-#else
-class GLShaderManager
-#endif
-	{
-	public:
-		GLShaderManager(void);
-		~GLShaderManager(void);
-
-        void freeGL(void); // Free GL resources
-		
-		// Call before using
-		bool InitializeStockShaders(void);
-	
-		// Use a stock shader, and pass in the parameters needed
-		GLint UseStockShader(int nShaderID, ...);
-
-		// Load a shader pair from file, return NULL or shader handle. 
-		// Vertex program name (minus file extension)
-		// is saved in the lookup table
-		GLuint LoadShaderPair(const char *szVertexProgFileName, const char *szFragProgFileName);
-
-		// Load shaders from source text.
-		GLuint LoadShaderPairSrc(const char *szName, const char *szVertexSrc, const char *szFragSrc);
-
-		// Ditto above, but pop in the attributes
-		GLuint LoadShaderPairWithAttributes(const char *szVertexProgFileName, const char *szFragmentProgFileName, ...);
-		GLuint LoadShaderPairSrcWithAttributes(const char *szName, const char *szVertexProg, const char *szFragmentProg, ...);
-
-	
-	protected:
-		GLuint	uiStockShaders[GLT_SHADER_LAST];
-	};
-
-
-#endif
+// GLShaderManager.h
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list 
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
+to endorse or promote products derived from this software without specific prior 
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __GLT_SHADER_MANAGER
+#define __GLT_SHADER_MANAGER
+
+#ifdef QT_IS_AVAILABLE
+#include <QOpenGLExtraFunctions>
+#endif
+
+#ifdef __APPLE__
+#include <TargetConditionals.h>
+#if TARGET_OS_IPHONE | TARGET_IPHONE_SIMULATOR
+#include <OpenGLES/ES3/gl.h>
+#define OPENGL_ES
+#else
+#include <GL/glew.h>
+#include <OpenGL/gl.h>		// Apple OpenGL haders (version depends on OS X SDK version)
+#endif
+#endif
+
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+#include "math3d.h"
+#include "GLStateCache.h"
+
+// Maximum length of shader name
+#define MAX_SHADER_NAME_LENGTH	64
+
+enum GLT_STOCK_SHADER { GLT_SHADER_IDENTITY = 0, GLT_SHADER_FLAT, GLT_SHADER_SHADED, GLT_SHADER_DEFAULT_LIGHT, GLT_SHADER_POINT_LIGHT_DIFF, GLT_SHADER_TEXTURE_REPLACE, GLT_SHADER_TEXTURE_MODULATE, GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF,
+                                GLT_SHADER_POINT_SPRITES, GLT_POINT_SPRITES_PLAIN, GLT_SHADER_FLAT_INSTANCED, GLT_SHADER_DEFAULT_LIGHT_INSTANCED,
+                                GLT_SHADER_POINT_LIGHT_DIFF_INSTANCED, GLT_SHADER_LAST };
+
+
+// The instance matrix takes four attribute slots, one per column, starting at
+// GLT_ATTRIBUTE_INSTANCE_MATRIX. See GLTriangleBatch::SetInstanceData().
+enum GLT_SHADER_ATTRIBUTE { GLT_ATTRIBUTE_VERTEX = 0, GLT_ATTRIBUTE_COLOR, GLT_ATTRIBUTE_NORMAL, 
+                                    GLT_ATTRIBUTE_TEXTURE0, GLT_ATTRIBUTE_TEXTURE1, GLT_ATTRIBUTE_TEXTURE2, GLT_ATTRIBUTE_TEXTURE3,
+                                    GLT_ATTRIBUTE_INSTANCE_MATRIX, GLT_ATTRIBUTE_INSTANCE_COLOR = GLT_ATTRIBUTE_INSTANCE_MATRIX + 4,
+                                    GLT_ATTRIBUTE_LAST};
+
+// Uniforms used by the stock shaders. Locations are looked up once when the
+// stock shaders are built; a shader that doesn't use one gets -1. The matrices,
+// color and light position live in the uniform blocks below, so today only
+// the texture unit has a location of its own.
+enum GLT_STOCK_UNIFORM { GLT_UNIFORM_MVP_MATRIX = 0, GLT_UNIFORM_MV_MATRIX, GLT_UNIFORM_P_MATRIX, GLT_UNIFORM_COLOR,
+                                    GLT_UNIFORM_LIGHT_POS, GLT_UNIFORM_TEXTURE_UNIT0, GLT_UNIFORM_LAST };
+
+
+// The stock shaders get their matrices, color and light position from two
+// std140 uniform blocks. The frame block is only uploaded when the projection
+// or light changes, the object block is written for every draw into a ring
+// buffer. These binding points are reserved for the stock shaders.
+#define GLT_UNIFORM_BLOCK_FRAME		0
+#define GLT_UNIFORM_BLOCK_OBJECT	1
+
+// Size of the ring buffer the blocks are written to. When it fills up, it is
+// orphaned and we start again at the beginning.
+#define GLT_UNIFORM_RING_SIZE		(256 * 1024)
+
+// Same layout as GLTFrameBlock in the shaders. vLightPos is a vec3, w is padding
+struct GLTFRAMEBLOCK {
+	M3DMatrix44f	pMatrix;
+	M3DVector4f		vLightPos;
+	};
+
+// Same layout as GLTObjectBlock in the shaders
+struct GLTOBJECTBLOCK {
+	M3DMatrix44f	mvMatrix;
+	M3DMatrix44f	mvpMatrix;
+	M3DVector4f		vColor;
+	};
+
+
+// GL_KHR_parallel_shader_compile, in case the headers are older than it
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR	0x91B1
+#endif
+
+// A shader pair that has been handed to the driver, but not checked yet.
+// A program that came out of the binary cache has no shaders.
+struct GLTSHADERBUILD {
+	GLuint		hProgram;
+	GLuint		hVertexShader;
+	GLuint		hFragmentShader;
+	GLuint64	nCacheKey;
+	};
+
+
+// Features of the uber shader (UseShaderVariant), OR them together.
+// GLT_FEATURE_INSTANCED reads a transform and color per instance, see
+// GLTriangleBatch::SetInstanceData().
+enum GLT_SHADER_FEATURE { GLT_FEATURE_VERTEX_COLOR = 0x01, GLT_FEATURE_TEXTURE = 0x02, GLT_FEATURE_DEFAULT_LIGHT = 0x04,
+                                GLT_FEATURE_POINT_LIGHT = 0x08, GLT_FEATURE_INSTANCED = 0x10 };
+
+#define GLT_FEATURE_BITS			5
+#define GLT_FEATURE_COMBINATIONS	(1 << GLT_FEATURE_BITS)
+
+// Source and attribute bindings of a shader pair we build ourselves
+#define GLT_STOCK_MAX_ATTRIBUTES	6
+
+struct GLTSTOCKSHADERSOURCE {
+	const char	*szVertexSrc;
+	const char	*szFragmentSrc;
+	int			nAttributes;
+	GLuint		iAttributes[GLT_STOCK_MAX_ATTRIBUTES];
+	const char	*szAttributes[GLT_STOCK_MAX_ATTRIBUTES];
+	};
+
+
+// Compile time tag that picks a stock shader's typed parameter list
+template<int nShaderID> struct GLTStockShaderTag { };
+
+
+struct SHADERLOOKUPENTRY {
+	char szVertexShaderName[MAX_SHADER_NAME_LENGTH];
+	char szFragShaderName[MAX_SHADER_NAME_LENGTH];
+	GLuint uiShaderID;
+	GLuint nRefCount;
+	};
+
+#ifdef QT_IS_AVAILABLE
+    class GLShaderManager: protected QOpenGLExtraFunctions
+#else
+class GLShaderManager
+#endif
+	{
+	public:
+		GLShaderManager(void);
+		~GLShaderManager(void);
+
+        void freeGL(void); // Free GL resources
+		
+		// Call before using. All the stock shaders are handed to the driver
+		// before any of them is checked. That only saves time with a driver
+		// that has GL_KHR_parallel_shader_compile (or the ARB version) and
+		// more than one compiler thread. Without it this takes as long as
+		// building them one after another. bench/StartupBench.cpp times it.
+		bool InitializeStockShaders(void);
+
+		// Lazy version, for apps that only use a few of the stock shaders. Just the
+		// ones in the warm up list are built now, the rest are built the first time
+		// UseStockShader asks for them:
+		//		int warmUp[] = { GLT_SHADER_FLAT, GLT_SHADER_DEFAULT_LIGHT };
+		//		shaderManager.InitializeStockShaders(true, warmUp, 2);
+		bool InitializeStockShaders(bool bLazy, const int *pWarmUp = NULL, int nWarmUp = 0);
+	
+		// Use a stock shader, and pass in the parameters needed
+		GLint UseStockShader(int nShaderID, ...);
+
+		// Type checked version of the above. The shader is picked at compile time
+		// and the parameters are the same, in the same order, but by reference:
+		//		shaderManager.UseStockShader<GLT_SHADER_FLAT>(mvpMatrix, vRed);
+		// A wrong parameter list won't compile.
+		template<int nShaderID, typename... Params>
+		inline GLint UseStockShader(const Params&... params)
+			{
+			static_assert(nShaderID >= 0 && nShaderID < GLT_SHADER_LAST, "Not a stock shader");
+			GLTOBJECTBLOCK objectBlock = {};
+
+			GLuint hProgram = GetStockShader(nShaderID);
+			if(hProgram == 0)
+				return -1;
+
+			GLStateCache::GetStateCache()->UseProgram(hProgram);
+			SetStockUniforms(GLTStockShaderTag<nShaderID>(), objectBlock, params...);
+			UploadStockBlocks(objectBlock);
+			return hProgram;
+			}
+
+		// Set the per frame values once, instead of on every draw. Calls that pass
+		// the same projection or light position again don't upload anything.
+		void SetFrameUniforms(const M3DMatrix44f &pMatrix, const M3DVector3f &vLightPos)
+			{
+			SetProjection(pMatrix);
+			SetLightPosition(vLightPos);
+			}
+
+		// Uber shader, for the combinations the stock shaders don't have. nFeatures
+		// is any combination of GLT_SHADER_FEATURE bits, and each combination is
+		// built the first time it's used:
+		//		shaderManager.UseShaderVariant(GLT_FEATURE_TEXTURE | GLT_FEATURE_POINT_LIGHT,
+		//										mvMatrix, pMatrix, vLightPos, vWhite, 0);
+		// The light position and texture unit are ignored by variants without them.
+		// Variants with GLT_FEATURE_INSTANCED are drawn with GLTriangleBatch::DrawInstanced.
+		// Call InitializeStockShaders first, the variants use the same uniform blocks.
+		GLint UseShaderVariant(GLuint nFeatures, const M3DMatrix44f &mvMatrix, const M3DMatrix44f &pMatrix,
+								const M3DVector3f &vLightPos, const M3DVector4f &vColor, GLint nTextureUnit = 0);
+		GLuint GetShaderVariant(GLuint nFeatures);
+
+		// Cached uniform location of a stock shader, -1 if it doesn't have that uniform
+		// (or, in lazy mode, hasn't been built yet)
+		GLint GetStockUniformLocation(int nShaderID, int nUniform) const
+			{
+			if(nShaderID < 0 || nShaderID >= GLT_SHADER_LAST || nUniform < 0 || nUniform >= GLT_UNIFORM_LAST)
+				return -1;
+			return iStockUniforms[nShaderID][nUniform];
+			}
+
+		// Load a shader pair from file, return NULL or shader handle. 
+		// Both file names are saved in the lookup table
+		GLuint LoadShaderPair(const char *szVertexProgFileName, const char *szFragProgFileName);
+
+		// Load shaders from source text. Saved under szName, or if that's
+		// NULL, under the source itself.
+		GLuint LoadShaderPairSrc(const char *szName, const char *szVertexSrc, const char *szFragSrc);
+
+		// Ditto above, but pop in the attributes
+		GLuint LoadShaderPairWithAttributes(const char *szVertexProgFileName, const char *szFragmentProgFileName, ...);
+		GLuint LoadShaderPairSrcWithAttributes(const char *szName, const char *szVertexProg, const char *szFragmentProg, ...);
+
+		// Loading a pair that is already in the table, with the same attribute
+		// bindings, doesn't build anything, it just returns the same program and
+		// adds a reference to it. The same files bound differently are another
+		// program. Named source is one program per name: loading the name again
+		// with different source or bindings prints an error and returns 0.
+		//
+		// Programs from the Load functions belong to the shader manager. Don't
+		// glDeleteProgram() them, freeGL would delete them a second time. Call
+		// ReleaseShader when you're done with one, and whatever is left goes in freeGL.
+		void ReleaseShader(GLuint hProgram);
+
+		// Find a pair that has already been loaded, by both its file names, or for
+		// source, just the name it was given. If the files were loaded with more
+		// than one set of bindings, it's the first one, or once that's released,
+		// one of the others. Zero if it isn't there. Doesn't add a reference.
+		GLuint LookupShader(const char *szVertexProg, const char *szFragProg = NULL);
+
+	
+	protected:
+		// Per frame values, these only mark the frame block dirty if they changed
+		inline void SetProjection(const M3DMatrix44f &pMatrix)
+			{
+			if(memcmp(frameBlock.pMatrix, pMatrix, sizeof(M3DMatrix44f)) != 0) {
+				memcpy(frameBlock.pMatrix, pMatrix, sizeof(M3DMatrix44f));
+				bFrameDirty = true;
+				}
+			}
+
+		inline void SetLightPosition(const M3DVector3f &vLightPos)
+			{
+			if(memcmp(frameBlock.vLightPos, vLightPos, sizeof(M3DVector3f)) != 0) {
+				memcpy(frameBlock.vLightPos, vLightPos, sizeof(M3DVector3f));
+				bFrameDirty = true;
+				}
+			}
+
+		// Write the object block (and the frame block if it changed) to the ring and bind them
+		void UploadStockBlocks(const GLTOBJECTBLOCK &objectBlock);
+
+		//////////////////////////////////////////////////////////////////
+		// Uniforms for each stock shader, one overload per shader
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_IDENTITY>, GLTOBJECTBLOCK &block, const M3DVector4f &vColor)
+			{
+			memcpy(block.vColor, vColor, sizeof(M3DVector4f));
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_FLAT>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvpMatrix, const M3DVector4f &vColor)
+			{
+			memcpy(block.mvpMatrix, mvpMatrix, sizeof(M3DMatrix44f));
+			memcpy(block.vColor, vColor, sizeof(M3DVector4f));
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_SHADED>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvpMatrix)
+			{
+			memcpy(block.mvpMatrix, mvpMatrix, sizeof(M3DMatrix44f));
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_DEFAULT_LIGHT>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvMatrix, const M3DMatrix44f &pMatrix,
+										const M3DVector4f &vColor)
+			{
+			memcpy(block.mvMatrix, mvMatrix, sizeof(M3DMatrix44f));
+			memcpy(block.vColor, vColor, sizeof(M3DVector4f));
+			SetProjection(pMatrix);
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_POINT_LIGHT_DIFF>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvMatrix, const M3DMatrix44f &pMatrix,
+										const M3DVector3f &vLightPos, const M3DVector4f &vColor)
+			{
+			memcpy(block.mvMatrix, mvMatrix, sizeof(M3DMatrix44f));
+			memcpy(block.vColor, vColor, sizeof(M3DVector4f));
+			SetProjection(pMatrix);
+			SetLightPosition(vLightPos);
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_TEXTURE_REPLACE>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvpMatrix, GLint nTextureUnit)
+			{
+			memcpy(block.mvpMatrix, mvpMatrix, sizeof(M3DMatrix44f));
+			glUniform1i(iStockUniforms[GLT_SHADER_TEXTURE_REPLACE][GLT_UNIFORM_TEXTURE_UNIT0], nTextureUnit);
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_TEXTURE_MODULATE>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvpMatrix, const M3DVector4f &vColor,
+										GLint nTextureUnit)
+			{
+			memcpy(block.mvpMatrix, mvpMatrix, sizeof(M3DMatrix44f));
+			memcpy(block.vColor, vColor, sizeof(M3DVector4f));
+			glUniform1i(iStockUniforms[GLT_SHADER_TEXTURE_MODULATE][GLT_UNIFORM_TEXTURE_UNIT0], nTextureUnit);
+			}
+
+		// The variadic version never set anything for this one, here it's the same as
+		// the point light shader, plus the texture unit.
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvMatrix, const M3DMatrix44f &pMatrix,
+										const M3DVector3f &vLightPos, const M3DVector4f &vColor, GLint nTextureUnit)
+			{
+			memcpy(block.mvMatrix, mvMatrix, sizeof(M3DMatrix44f));
+			memcpy(block.vColor, vColor, sizeof(M3DVector4f));
+			SetProjection(pMatrix);
+			SetLightPosition(vLightPos);
+			glUniform1i(iStockUniforms[GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF][GLT_UNIFORM_TEXTURE_UNIT0], nTextureUnit);
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_POINT_SPRITES>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvpMatrix, GLint nTextureUnit)
+			{
+			memcpy(block.mvpMatrix, mvpMatrix, sizeof(M3DMatrix44f));
+			glUniform1i(iStockUniforms[GLT_SHADER_POINT_SPRITES][GLT_UNIFORM_TEXTURE_UNIT0], nTextureUnit);
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_POINT_SPRITES_PLAIN>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvpMatrix)
+			{
+			memcpy(block.mvpMatrix, mvpMatrix, sizeof(M3DMatrix44f));
+			}
+
+		// The instanced shaders take the same uniforms as the plain ones. Each
+		// instance's transform goes on the right of the model view, and its
+		// color is multiplied with vColor.
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_FLAT_INSTANCED>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvpMatrix, const M3DVector4f &vColor)
+			{
+			SetStockUniforms(GLTStockShaderTag<GLT_SHADER_FLAT>(), block, mvpMatrix, vColor);
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_DEFAULT_LIGHT_INSTANCED>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvMatrix, const M3DMatrix44f &pMatrix,
+										const M3DVector4f &vColor)
+			{
+			SetStockUniforms(GLTStockShaderTag<GLT_SHADER_DEFAULT_LIGHT>(), block, mvMatrix, pMatrix, vColor);
+			}
+
+		inline void SetStockUniforms(GLTStockShaderTag<GLT_SHADER_POINT_LIGHT_DIFF_INSTANCED>, GLTOBJECTBLOCK &block, const M3DMatrix44f &mvMatrix, const M3DMatrix44f &pMatrix,
+										const M3DVector3f &vLightPos, const M3DVector4f &vColor)
+			{
+			SetStockUniforms(GLTStockShaderTag<GLT_SHADER_POINT_LIGHT_DIFF>(), block, mvMatrix, pMatrix, vLightPos, vColor);
+			}
+
+		// Building our own shaders. Start hands one to the driver without waiting
+		// for it, Finish checks how it went and returns the program, or 0.
+		void StartShaderBuild(const GLTSTOCKSHADERSOURCE &source, GLTSHADERBUILD &build);
+		bool ShaderBuildReady(const GLTSHADERBUILD &build);
+		GLuint FinishShaderBuild(GLTSHADERBUILD &build);
+
+		void StartStockShader(int nShaderID, GLTSHADERBUILD &build);
+		void SetupStockShader(int nShaderID);
+		void BindUniformBlocks(GLuint hProgram);
+
+		// Handle of a stock shader, building it first if it hasn't been yet.
+		// One that already failed isn't tried again every draw.
+		inline GLuint GetStockShader(int nShaderID)
+			{
+			if(uiStockShaders[nShaderID] != 0 || bStockFailed[nShaderID])
+				return uiStockShaders[nShaderID];
+			return BuildStockShader(nShaderID);
+			}
+
+		GLuint BuildStockShader(int nShaderID);
+
+		GLuint	uiStockShaders[GLT_SHADER_LAST];
+		bool	bStockFailed[GLT_SHADER_LAST];
+		GLint	iStockUniforms[GLT_SHADER_LAST][GLT_UNIFORM_LAST];
+
+		// Uniform block ring buffer, and the CPU copy of the frame block
+		GLuint			uiUniformRing;
+		GLintptr		nRingOffset;
+		GLintptr		nFrameOffset;
+		GLint			nRingAlignment;
+		GLTFRAMEBLOCK	frameBlock;
+		bool			bFrameDirty;
+
+		// Driver has GL_KHR_parallel_shader_compile, the only case where
+		// polling the batched build for whichever program is done first helps
+		bool			bParallelCompile;
+
+		// Uber shader variants, by feature mask
+		GLuint	uiVariants[GLT_FEATURE_COMBINATIONS];
+		GLint	iVariantTextureUnit[GLT_FEATURE_COMBINATIONS];
+
+		// Shaders loaded by the Load functions, and what each program is filed under
+		typedef std::unordered_map<std::string, SHADERLOOKUPENTRY> SHADERTABLE;
+		SHADERTABLE								shaderTable;
+		std::unordered_map<GLuint, std::string>	shaderKeys;
+		std::unordered_map<std::string, GLuint>	shaderNames;	// For LookupShader
+
+		GLuint FindShader(const std::string &strKey);
+		void AddShader(const std::string &strKey, const char *szVertexName, const char *szFragName, GLuint hProgram);
+		bool ShaderNameTaken(const std::string &strKey, const char *szName);
+	};
+
+
+#endif
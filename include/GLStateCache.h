@@ -0,0 +1,198 @@
+// GLStateCache.h
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __GLT_STATE_CACHE
+#define __GLT_STATE_CACHE
+
+#ifdef QT_IS_AVAILABLE
+#include <QOpenGLExtraFunctions>
+#endif
+
+#ifdef __APPLE__
+#include <TargetConditionals.h>
+#if TARGET_OS_IPHONE | TARGET_IPHONE_SIMULATOR
+#include <OpenGLES/ES3/gl.h>
+#define OPENGL_ES
+#else
+#include <GL/glew.h>
+#include <OpenGL/gl.h>		// Apple OpenGL haders (version depends on OS X SDK version)
+#endif
+#endif
+
+#include <stddef.h>
+
+// Texture units and texture targets (2D, cube map, 2D array, 3D) that are tracked.
+// Anything else is passed straight through.
+#define GLT_STATE_TEXTURE_UNITS		16
+#define GLT_STATE_TEXTURE_TARGETS	4
+
+// What we think is bound when we really don't know
+#define GLT_STATE_UNKNOWN			0xFFFFFFFF
+
+enum GLT_STATE_BINDING { GLT_STATE_PROGRAM = 0, GLT_STATE_VERTEX_ARRAY, GLT_STATE_ARRAY_BUFFER, GLT_STATE_ELEMENT_BUFFER,
+                                GLT_STATE_UNIFORM_BUFFER, GLT_STATE_ACTIVE_TEXTURE, GLT_STATE_TEXTURE, GLT_STATE_FRAMEBUFFER, GLT_STATE_LAST };
+
+// Bind calls that went to the driver, and ones that were dropped because
+// the object was already bound.
+struct GLTSTATESTATS {
+    GLuint	nIssued[GLT_STATE_LAST];
+    GLuint	nFiltered[GLT_STATE_LAST];
+    };
+
+
+////////////////////////////////////////////////////////////////////
+// Shadow copy of the object bindings. GLBatch, GLTriangleBatch,
+// GLShaderManager and GLFrameBuffer do all of their binding through
+// here, so a bind of what is already bound never reaches the driver.
+//
+// Filtering is off until you call Enable(true), because it only works
+// if nobody changes these bindings behind its back. If your own code
+// calls glUseProgram, glBindVertexArray and so on directly, either use
+// the methods here instead, or call Invalidate() afterwards. Like
+// GLTools, there is one of these, for one context.
+#ifdef QT_IS_AVAILABLE
+class GLStateCache : public QOpenGLExtraFunctions
+#else
+class GLStateCache
+#endif
+    {
+    public:
+        static GLStateCache* GetStateCache(void) {
+            if(pMe == NULL) {
+                pMe = new GLStateCache();
+                #ifdef QT_IS_AVAILABLE
+                    pMe->initializeOpenGLFunctions();
+                #endif
+                }
+            return pMe;
+            }
+
+        // Turn filtering on or off. Either way we start from not knowing anything.
+        void Enable(bool bEnable) { bEnabled = bEnable; Invalidate(); }
+        bool IsEnabled(void) { return bEnabled; }
+
+        // Forget everything, the next bind of each kind goes to the driver
+        void Invalidate(void);
+
+        const GLTSTATESTATS& GetStats(void) { return stats; }
+        void ResetStats(void);
+
+        inline void UseProgram(GLuint program)
+            {
+            if(!Filter(GLT_STATE_PROGRAM, uiProgram, program))
+                glUseProgram(program);
+            }
+
+        // The element buffer binding belongs to the vertex array object,
+        // so we no longer know what it is once the VAO changes.
+        inline void BindVertexArray(GLuint vao)
+            {
+            if(Filter(GLT_STATE_VERTEX_ARRAY, uiVertexArray, vao))
+                return;
+
+            glBindVertexArray(vao);
+            uiElementBuffer = GLT_STATE_UNKNOWN;
+            }
+
+        // Only GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER and GL_UNIFORM_BUFFER are tracked
+        inline void BindBuffer(GLenum target, GLuint buffer)
+            {
+            if(target == GL_ARRAY_BUFFER) {
+                if(Filter(GLT_STATE_ARRAY_BUFFER, uiArrayBuffer, buffer))
+                    return;
+                }
+            else if(target == GL_ELEMENT_ARRAY_BUFFER) {
+                if(Filter(GLT_STATE_ELEMENT_BUFFER, uiElementBuffer, buffer))
+                    return;
+                }
+            else if(target == GL_UNIFORM_BUFFER) {
+                if(Filter(GLT_STATE_UNIFORM_BUFFER, uiUniformBuffer, buffer))
+                    return;
+                }
+
+            glBindBuffer(target, buffer);
+            }
+
+        // Indexed ranges are never filtered, but binding one also binds the
+        // buffer to the generic target, so keep track of that.
+        inline void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+            {
+            glBindBufferRange(target, index, buffer, offset, size);
+            if(target == GL_UNIFORM_BUFFER)
+                uiUniformBuffer = buffer;
+            }
+
+        inline void ActiveTexture(GLenum texture)
+            {
+            if(!Filter(GLT_STATE_ACTIVE_TEXTURE, uiActiveTexture, texture))
+                glActiveTexture(texture);
+            }
+
+        void BindTexture(GLenum target, GLuint texture);
+        void BindFramebuffer(GLenum target, GLuint framebuffer);
+
+        // Call these when objects are deleted. GL unbinds a deleted object,
+        // and its name may be handed out again by the next glGen*.
+        static void ForgetProgram(GLuint program);
+        static void ForgetVertexArrays(GLsizei n, const GLuint *pArrays);
+        static void ForgetBuffers(GLsizei n, const GLuint *pBuffers);
+        static void ForgetTextures(GLsizei n, const GLuint *pTextures);
+        static void ForgetFramebuffers(GLsizei n, const GLuint *pFramebuffers);
+
+    protected:
+        GLStateCache(void) { bEnabled = false; Invalidate(); ResetStats(); }
+
+        // True if the call can be dropped. Otherwise count it and remember the new binding.
+        inline bool Filter(int nBinding, GLuint &uiCurrent, GLuint uiNew)
+            {
+            if(bEnabled && uiCurrent == uiNew) {
+                stats.nFiltered[nBinding]++;
+                return true;
+                }
+
+            uiCurrent = uiNew;
+            stats.nIssued[nBinding]++;
+            return false;
+            }
+
+        static GLStateCache*	pMe;
+
+        bool			bEnabled;
+        GLTSTATESTATS	stats;
+
+        GLuint	uiProgram;
+        GLuint	uiVertexArray;
+        GLuint	uiArrayBuffer;
+        GLuint	uiElementBuffer;
+        GLuint	uiUniformBuffer;
+        GLuint	uiActiveTexture;
+        GLuint	uiTextures[GLT_STATE_TEXTURE_UNITS][GLT_STATE_TEXTURE_TARGETS];
+        GLuint	uiDrawFramebuffer;
+        GLuint	uiReadFramebuffer;
+    };
+
+
+#endif
@@ -1,157 +1,195 @@
-// GLTools.h
-// OpenGL SuperBible
-/* Copyright 1998 - 2023 Richard S. Wright Jr.
-All rights reserved.
-
-Redistribution and use in source, with or without modification, 
-are permitted provided that the following conditions are met:
-
-Redistributions of source code must retain the above copyright notice, this list 
-of conditions and the following disclaimer.
-
-Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
-to endorse or promote products derived from this software without specific prior 
-written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
-EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
-OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
-SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
-INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
-TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
-BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
-CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
-ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#ifndef __GLTOOLS__LIBRARY
-#define __GLTOOLS__LIBRARY
-
-#ifdef QT_IS_AVAILABLE
-#include <qopenglextrafunctions.h>
-#endif
-
-// Mac OS X
-#ifdef __APPLE__
-#include <TargetConditionals.h>
-#if TARGET_OS_IPHONE | TARGET_IPHONE_SIMULATOR
-#include <OpenGLES/ES3/gl.h>
-#define OPENGL_ES
-#else
-#include <GL/glew.h>
-#include <OpenGL/gl.h>		// Apple OpenGL haders (version depends on OS X SDK version)
-#endif
-#endif
-
-
-#include <stdio.h>
-#include <assert.h>
-#include <stdarg.h>
-#include <stdlib.h>
-#include <string.h>
-
-#ifndef _WIN32
-#include <unistd.h>
-#endif
-
-// There is a static block allocated for loading shaders to 
-// prevent heap fragmentation, as this could happend frequently
-// and is likely long enough.
-#define MAX_SHADER_LENGTH   8192
-
-// Universal includes
-#include <stdio.h>
-#include <math.h>
-#include "math3d.h"
-#include "GLBatch.h"
-#include "GLTriangleBatch.h"
-
-#ifdef QT_IS_AVAILABLE
-class GLTools : public QOpenGLExtraFunctions
-#else
-class GLTools
-#endif
-    {
-	public:
-		GLTools() { pMe = NULL; }
-		
-		static GLTools* GetGLTools() {
-			if(pMe == NULL) {
-				pMe = new GLTools();
-                pMe->InitializeGL();
-				}
-			return pMe;
-		}
-
-		void InitializeGL(void) {
-            #ifdef QT_IS_AVAILABLE
-                initializeOpenGLFunctions();
-            #endif
-    }
-
-	// Shader loading support
-	void gltLoadShaderSrc(const char *szShaderSrc, GLuint shader);
-    bool gltLoadShaderFile(const char *szFile, GLuint shader);
-
-	GLuint	gltLoadShaderPair(const char *szVertexProg, const char *szFragmentProg);
-	GLuint   gltLoadShaderPairWithAttributes(const char *szVertexProg, const char *szFragmentProg, ...);
-
-	GLuint gltLoadShaderPairSrc(const char *szVertexSrc, const char *szFragmentSrc);
-	GLuint gltLoadShaderPairSrcWithAttributes(const char *szVertexProg, const char *szFragmentProg, ...);
-
-	bool gltCheckErrors(GLuint progName = 0);
-
-	protected:
-		static GLTools*	pMe;
-
-	public:
-		static GLubyte szVendor[64];
-		static GLubyte szRenderer[64];
-		static GLubyte szVersion[64];
-	};
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-//         THE LIBRARY....
-///////////////////////////////////////////////////////////////////////////////
-
-// Get the OpenGL version
-void gltGetOpenGLVersion(GLint &nMajor, GLint &nMinor);
-
-// Set working directory to /Resources on the Mac
-void gltSetWorkingDirectory(const char *szArgv);
-
-///////////////////////////////////////////////////////////////////////////////
-// Win32 Only
-#ifdef WIN32
-BYTE* gltReadBMPBits(const char *szFileName, int *nWidth, int *nHeight);
-#endif
-
-/////////////////////////////////////////////////////////////////////////////////////
-// Load a .TGA file
-GLbyte *gltReadTGABits(const char *szFileName, GLint *iWidth, GLint *iHeight, GLint *iComponents, GLenum *eFormat);
-
-// Capture the frame buffer and write it as a .tga
-// Does not work on the iPhone
-#ifndef OPENGL_ES
-GLint gltGrabScreenTGA(const char *szFileName);
-#endif
-
-
-void gltComputeNormalMatrix(M3DMatrix33f& mNormal, const M3DMatrix44f& mModelView);
-
-
-class GLTriangleBatch;
-
-// Make Objects
-void gltMakeTorus(GLTriangleBatch& torusBatch, GLfloat majorRadius, GLfloat minorRadius, GLint numMajor, GLint numMinor);
-void gltMakeSphere(GLTriangleBatch& sphereBatch, GLfloat fRadius, GLint iSlices, GLint iStacks);
-void gltMakeDisk(GLTriangleBatch& diskBatch, GLfloat innerRadius, 
-                    GLfloat outerRadius, GLint nSlices, GLint nStacks, GLfloat fDegrees = 360.0f);
-void gltMakeCylinder(GLTriangleBatch& cylinderBatch, GLfloat baseRadius, GLfloat topRadius, 
-                            GLfloat fLength, GLint numSlices, GLint numStacks, GLfloat fDegrees = 360.0f);
-void gltMakeCube(GLBatch& cubeBatch, GLfloat fRadius);
-
-
-#endif
+// GLTools.h
+// OpenGL SuperBible
+/* Copyright 1998 - 2023 Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source, with or without modification, 
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list 
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
+to endorse or promote products derived from this software without specific prior 
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __GLTOOLS__LIBRARY
+#define __GLTOOLS__LIBRARY
+
+#ifdef QT_IS_AVAILABLE
+#include <qopenglextrafunctions.h>
+#endif
+
+// Mac OS X
+#ifdef __APPLE__
+#include <TargetConditionals.h>
+#if TARGET_OS_IPHONE | TARGET_IPHONE_SIMULATOR
+#include <OpenGLES/ES3/gl.h>
+#define OPENGL_ES
+#else
+#include <GL/glew.h>
+#include <OpenGL/gl.h>		// Apple OpenGL haders (version depends on OS X SDK version)
+#endif
+#endif
+
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Shader files used to be read into a static block of this size. They
+// aren't any more, and can be any length, but the define stays for
+// code that still uses it.
+#define MAX_SHADER_LENGTH   8192
+
+// Program binary cache. Longest cache directory path we'll keep, and the
+// largest binary we'll believe when reading one back.
+#define GLT_PROGRAM_CACHE_PATH      256
+#define GLT_PROGRAM_BINARY_MAX      (16*1024*1024)
+
+// Every cached binary starts with this
+#define GLT_PROGRAM_BINARY_MAGIC    0x50544C47      // "GLTP"
+#define GLT_PROGRAM_BINARY_VERSION  1
+
+struct GLTPROGRAMBINARYHEADER {
+    GLuint      nMagic;
+    GLuint      nVersion;
+    GLuint64    nKey;
+    GLenum      format;
+    GLuint      nLength;
+    };
+
+// Universal includes
+#include <stdio.h>
+#include <math.h>
+#include "math3d.h"
+#include "GLBatch.h"
+#include "GLTriangleBatch.h"
+
+#ifdef QT_IS_AVAILABLE
+class GLTools : public QOpenGLExtraFunctions
+#else
+class GLTools
+#endif
+    {
+	public:
+		GLTools() { pMe = NULL; szProgramCache[0] = '\0'; }
+		
+		static GLTools* GetGLTools() {
+			if(pMe == NULL) {
+				pMe = new GLTools();
+                pMe->InitializeGL();
+				}
+			return pMe;
+		}
+
+		void InitializeGL(void) {
+            #ifdef QT_IS_AVAILABLE
+                initializeOpenGLFunctions();
+            #endif
+    }
+
+	// Shader loading support
+	void gltLoadShaderSrc(const char *szShaderSrc, GLuint shader);
+    bool gltLoadShaderFile(const char *szFile, GLuint shader);
+
+	GLuint	gltLoadShaderPair(const char *szVertexProg, const char *szFragmentProg);
+	GLuint   gltLoadShaderPairWithAttributes(const char *szVertexProg, const char *szFragmentProg, ...);
+
+	GLuint gltLoadShaderPairSrc(const char *szVertexSrc, const char *szFragmentSrc);
+	GLuint gltLoadShaderPairSrcWithAttributes(const char *szVertexProg, const char *szFragmentProg, ...);
+
+	bool gltCheckErrors(GLuint progName = 0);
+
+	// Program binary cache. Off until you give it a directory (which must
+	// already exist) to keep the binaries in, pass NULL to turn it off again.
+	// All of the shader pair loaders, and the stock shaders, go through it.
+	void gltSetProgramCacheDirectory(const char *szDirectory);
+
+	// Key for a pair of shaders with their source loaded, and the attributes that
+	// will be bound. Zero if the cache is off, which the other two just ignore.
+	GLuint64 gltProgramCacheKey(GLuint hVertexShader, GLuint hFragmentShader, int nAttributes, va_list *pAttributes);
+	GLuint64 gltProgramCacheKey(GLuint hVertexShader, GLuint hFragmentShader, int nAttributes, const GLuint *pIndexes, const char * const *pNames);
+	GLuint gltLoadProgramBinary(GLuint64 nKey);
+	void gltSaveProgramBinary(GLuint64 nKey, GLuint hProgram);
+
+	protected:
+		static GLTools*	pMe;
+
+		GLuint64 StartProgramCacheKey(GLuint hVertexShader, GLuint hFragmentShader, int nAttributes);
+		GLuint64 FinishProgramCacheKey(GLuint64 nHash);
+
+		char	szProgramCache[GLT_PROGRAM_CACHE_PATH];
+
+	public:
+		static GLubyte szVendor[64];
+		static GLubyte szRenderer[64];
+		static GLubyte szVersion[64];
+	};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//         THE LIBRARY....
+///////////////////////////////////////////////////////////////////////////////
+
+// Get the OpenGL version
+void gltGetOpenGLVersion(GLint &nMajor, GLint &nMinor);
+
+// Read a shader file into a new [] buffer of exactly its length. No GL
+// calls, so it can be done on a loader thread. NULL if it can't be read.
+char* gltReadShaderFile(const char *szFile, size_t *pLength);
+
+// Set working directory to /Resources on the Mac
+void gltSetWorkingDirectory(const char *szArgv);
+
+///////////////////////////////////////////////////////////////////////////////
+// Win32 Only
+#ifdef WIN32
+BYTE* gltReadBMPBits(const char *szFileName, int *nWidth, int *nHeight);
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Load a .TGA file
+GLbyte *gltReadTGABits(const char *szFileName, GLint *iWidth, GLint *iHeight, GLint *iComponents, GLenum *eFormat);
+
+// Capture the frame buffer and write it as a .tga
+// Does not work on the iPhone
+#ifndef OPENGL_ES
+GLint gltGrabScreenTGA(const char *szFileName);
+#endif
+
+
+void gltComputeNormalMatrix(M3DMatrix33f& mNormal, const M3DMatrix44f& mModelView);
+
+
+class GLTriangleBatch;
+
+// Make Objects
+void gltMakeTorus(GLTriangleBatch& torusBatch, GLfloat majorRadius, GLfloat minorRadius, GLint numMajor, GLint numMinor);
+void gltMakeSphere(GLTriangleBatch& sphereBatch, GLfloat fRadius, GLint iSlices, GLint iStacks);
+void gltMakeDisk(GLTriangleBatch& diskBatch, GLfloat innerRadius, 
+                    GLfloat outerRadius, GLint nSlices, GLint nStacks, GLfloat fDegrees = 360.0f);
+void gltMakeCylinder(GLTriangleBatch& cylinderBatch, GLfloat baseRadius, GLfloat topRadius, 
+                            GLfloat fLength, GLint numSlices, GLint numStacks, GLfloat fDegrees = 360.0f);
+void gltMakeCube(GLBatch& cubeBatch, GLfloat fRadius);
+
+
+#endif
@@ -1,105 +1,274 @@
-/*
- *  GLTriangleBatch.h
- *  OpenGL SuperBible
- *
-Copyright (c) 2007-2023, Richard S. Wright Jr.
-All rights reserved.
-
-Redistribution and use in source forms, with or without modification, 
-are permitted provided that the following conditions are met:
-
-Redistributions of source code must retain the above copyright notice, this list 
-of conditions and the following disclaimer.
-
-Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
-to endorse or promote products derived from this software without specific prior 
-written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
-EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
-OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
-SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
-INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
-TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
-BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
-CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
-ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
- *  This class allows you to simply add triangles as if this class were a 
- *  container. The AddTriangle() function searches the current list of triangles
- *  and determines if the vertex/normal/texcoord is a duplicate. If so, it addes
- *  an entry to the index array instead of the list of vertices.
- *  When finished, call EndMesh() to free up extra unneeded memory that is reserved
- *  as workspace when you call BeginMesh().
- *
- *  This class can easily be extended to contain other vertex attributes, and to 
- *  save itself and load itself from disk (thus forming the beginnings of a custom
- *  model file format).
- *
- */
-
-#ifndef __GLT_TRIANGLE_BATCH
-#define __GLT_TRIANGLE_BATCH
-
-#include <stdio.h>
-#include <limits.h>
-
-#include "math3d.h"
-#include "GLBatchBase.h"
-#include "GLShaderManager.h"
-
-
-#define VERTEX_DATA     0
-#define NORMAL_DATA     1
-#define TEXTURE_DATA    2
-#define INDEX_DATA      3
-
-#ifdef QT_IS_AVAILABLE
-#include <qopenglextrafunctions.h>
-class GLTriangleBatch : public GLBatchBase
-#else
-class GLTriangleBatch
-#endif
-    {
-    public:
-        GLTriangleBatch(void);
-        virtual ~GLTriangleBatch(void);
-        
-        // Use these three functions to add triangles
-        void BeginMesh(GLuint nMaxVerts);
-        void AddTriangle(M3DVector3f verts[3], M3DVector3f vNorms[3], M3DVector2f vTexCoords[3], float epsilon = 0.00001f, int nCheckRange = INT_MAX);
-        void End(void);
-
-        // Useful for statistics
-        inline GLuint GetIndexCount(void) { return nNumIndexes; }
-        inline GLuint GetVertexCount(void) { return nNumVerts; }
-
-		inline GLfloat GetBoundingSphere(void) { return boundingSphereRadius; }
-
-		bool SaveMesh(const char *szFileName);
-		bool LoadMesh(const char *szFileName, bool bNormals = true, bool bTexCoords = true);
-        
-        bool SaveMesh(FILE *pFile);
-        bool LoadMesh(FILE *pFile, bool bNormals = true, bool bTexCoords = true);
-        
-        // Draw - make sure you call glEnableClientState for these arrays
-        virtual void Draw(void);
-        
-    protected:
-        GLushort  *pIndexes = nullptr;         // Array of indexes
-        M3DVector3f *pVerts = nullptr;         // Array of vertices
-        M3DVector3f *pNorms = nullptr;         // Array of normals
-        M3DVector2f *pTexCoords = nullptr;     // Array of texture coordinates
-        
-        GLuint nMaxIndexes;         // Maximum workspace
-        GLuint nNumIndexes;         // Number of indexes currently used
-        GLuint nNumVerts;           // Number of vertices actually used
-        
-        bool   bMadeStuff;
-        GLuint bufferObjects[4];
-        GLuint vertexArrayBufferObject;
-        GLfloat	boundingSphereRadius;
-    };
-
-
-#endif
+/*
+ *  GLTriangleBatch.h
+ *  OpenGL SuperBible
+ *
+Copyright (c) 2007-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list 
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
+to endorse or promote products derived from this software without specific prior 
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ *  This class allows you to simply add triangles as if this class were a 
+ *  container. The AddTriangle() function searches the current list of triangles
+ *  and determines if the vertex/normal/texcoord is a duplicate. If so, it addes
+ *  an entry to the index array instead of the list of vertices.
+ *  When finished, call EndMesh() to free up extra unneeded memory that is reserved
+ *  as workspace when you call BeginMesh().
+ *
+ *  This class can easily be extended to contain other vertex attributes, and to 
+ *  save itself and load itself from disk (thus forming the beginnings of a custom
+ *  model file format).
+ *
+ */
+
+#ifndef __GLT_TRIANGLE_BATCH
+#define __GLT_TRIANGLE_BATCH
+
+#include <stdio.h>
+#include <limits.h>
+
+#include "math3d.h"
+#include "GLBatchBase.h"
+#include "GLShaderManager.h"
+
+
+#define VERTEX_DATA     0
+#define NORMAL_DATA     1
+#define TEXTURE_DATA    2
+#define INDEX_DATA      3
+
+// Options for GLTriangleBatch::End(), these can be or'ed together
+#define GLT_BATCH_INTERLEAVED       0x0001  // One vertex buffer, attributes side by side
+#define GLT_BATCH_OPTIMIZE_VCACHE   0x0002  // Reorder triangles for the post-transform cache
+#define GLT_BATCH_OPTIMIZE_VFETCH   0x0004  // Renumber vertices in the order they are first used
+#define GLT_BATCH_COMPRESS_POSITIONS 0x0008 // Normalized shorts, see GetPositionDecodeMatrix()
+#define GLT_BATCH_COMPRESS_NORMALS  0x0010  // GL_INT_2_10_10_10_REV
+#define GLT_BATCH_COMPRESS_TEXCOORDS 0x0020 // Half floats
+#define GLT_BATCH_COMPRESS          (GLT_BATCH_COMPRESS_POSITIONS | GLT_BATCH_COMPRESS_NORMALS | GLT_BATCH_COMPRESS_TEXCOORDS)
+
+// How well the compression went. Errors are the largest difference in any one
+// component between the original and what the shader will see.
+struct GLTCOMPRESSIONREPORT {
+    GLfloat fMaxPositionError;      // Model space units
+    GLfloat fMaxNormalError;
+    GLfloat fMaxTexCoordError;
+    GLuint  nVertexBytes;           // What was uploaded
+    GLuint  nUncompressedBytes;     // What it would have been as floats
+    };
+
+// Mesh file header, written by SaveMesh(). Each section starts on a
+// GLT_MESH_ALIGNMENT boundary so the file can be mapped straight into memory.
+#define GLT_MESH_MAGIC          0x4D544C47  // 'GLTM'
+#define GLT_MESH_VERSION        1
+#define GLT_MESH_ALIGNMENT      4096
+
+#define GLT_MESH_STREAM_CHUNK       (1024 * 1024)   // Default for LoadMeshStreamed()
+#define GLT_MESH_CHUNK_GRANULARITY  24              // Chunks hold whole indexes and vertices
+
+#define GLT_MESH_NORMALS        0x0001
+#define GLT_MESH_TEXCOORDS      0x0002
+
+struct GLTMESHHEADER {
+    GLuint  magic;                  // GLT_MESH_MAGIC
+    GLuint  version;                // GLT_MESH_VERSION
+    GLuint  flags;                  // GLT_MESH_NORMALS and/or GLT_MESH_TEXCOORDS
+    GLuint  indexSize;              // 1, 2, or 4 bytes per index
+    GLuint  numIndexes;
+    GLuint  numVerts;
+    GLfloat boundingSphereRadius;
+    GLfloat boundsMin[3];
+    GLfloat boundsMax[3];
+    GLuint  reserved;
+    unsigned long long sectionOffset[4];    // From the start of the file, indexed by VERTEX_DATA etc.
+    unsigned long long sectionSize[4];      // In bytes, 0 if not present
+    };
+
+// A mesh read into memory by GLTriangleBatch::ReadMeshData(), waiting to be uploaded
+struct GLTMESHDATA {
+    GLTMESHHEADER header;           // Section sizes are what's in memory
+    GLubyte *pSections[4];          // Indexed by VERTEX_DATA etc., NULL if not there
+    unsigned long long nUploaded;   // Bytes UploadChunk() has done so far
+    };
+
+// One instance for DrawInstanced(), as it is laid out in the instance buffer.
+// The columns of the transform and the color are read with a divisor of one,
+// from GLT_ATTRIBUTE_INSTANCE_MATRIX (four slots) and GLT_ATTRIBUTE_INSTANCE_COLOR.
+struct GLTINSTANCEDATA {
+    M3DMatrix44f mTransform;        // Applied before the model view matrix
+    M3DVector4f  vColor;            // Multiplied with the shader's color
+    };
+
+#ifdef QT_IS_AVAILABLE
+#include <qopenglextrafunctions.h>
+class GLTriangleBatch : public GLBatchBase
+#else
+class GLTriangleBatch
+#endif
+    {
+    public:
+        GLTriangleBatch(void);
+        virtual ~GLTriangleBatch(void);
+        
+        // Use these three functions to add triangles
+        void BeginMesh(GLuint nMaxVerts);
+        void AddTriangle(M3DVector3f verts[3], M3DVector3f vNorms[3], M3DVector2f vTexCoords[3], float epsilon = 0.00001f, int nCheckRange = INT_MAX);
+        void End(GLuint nOptions = 0);
+
+        // Or add a whole mesh at once. This is much faster for big meshes. False,
+        // and nothing added, if the indexes or the count are bad or it won't fit.
+        bool AddTriangles(GLuint nTriangles, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords, float epsilon = 0.00001f);
+        bool AddIndexedMesh(GLuint nVerts, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords,
+                            GLuint nIndexes, const GLuint *pMeshIndexes, float epsilon = 0.00001f);
+
+        // Duplicate vertices are found with a spatial hash (the default). Turn
+        // this off to fall back to searching every vertex already in the batch.
+        inline void SetWeldHash(bool bEnable) { bWeldHash = bEnable; }
+
+        // Share the AddTriangles() and AddIndexedMesh() weld out over this many
+        // threads (0 for one per core). The result is exactly the serial weld,
+        // but setting up the split costs more than it saves on one core, so 1,
+        // the default, just runs the serial weld. See bench/WeldBench.cpp.
+        inline void SetWeldThreads(GLuint nThreads) { nWeldThreads = nThreads; }
+
+        // Useful for statistics
+        inline GLuint GetIndexCount(void) { return nNumIndexes; }
+        inline GLuint GetVertexCount(void) { return nNumVerts; }
+        inline GLenum GetIndexType(void) { return indexType; }
+
+		inline GLfloat GetBoundingSphere(void) { return boundingSphereRadius; }
+        inline void GetBoundingBox(M3DVector3f vMin, M3DVector3f vMax) { m3dCopyVector3(vMin, vBoundsMin); m3dCopyVector3(vMax, vBoundsMax); }
+
+        // Average cache miss ratio (vertices transformed per triangle) before and
+        // after End() reordered the triangles. Both are 0 unless GLT_BATCH_OPTIMIZE_VCACHE was used.
+        inline void GetACMR(GLfloat &fBefore, GLfloat &fAfter) { fBefore = fACMRBefore; fAfter = fACMRAfter; }
+
+        // Only meaningful after End() with one of the GLT_BATCH_COMPRESS flags.
+        // Compressed positions must be drawn with the decode matrix applied.
+        inline void GetCompressionReport(GLTCOMPRESSIONREPORT &report) { report = compressionReport; }
+        void GetPositionDecodeMatrix(M3DMatrix44f mDecode);
+
+        // Save and load the finished mesh. Old headerless files can still be loaded,
+        // for those you need to say if there are normals and texture coordinates.
+		bool SaveMesh(const char *szFileName);
+		bool LoadMesh(const char *szFileName, bool bNormals = true, bool bTexCoords = true);
+        
+        bool SaveMesh(FILE *pFile);
+        bool LoadMesh(FILE *pFile, bool bNormals = true, bool bTexCoords = true);
+
+        // Load a mesh using no more than nChunkSize bytes of memory along the way
+        bool LoadMeshStreamed(const char *szFileName, bool bNormals = true, bool bTexCoords = true, GLuint nChunkSize = GLT_MESH_STREAM_CHUNK);
+        bool LoadMeshStreamed(FILE *pFile, bool bNormals = true, bool bTexCoords = true, GLuint nChunkSize = GLT_MESH_STREAM_CHUNK);
+
+        // Loading split in two. ReadMeshData() doesn't use OpenGL and can be called
+        // from any thread, the upload (all at once, or a chunk at a time) goes on the GL thread.
+        static bool ReadMeshData(FILE *pFile, bool bNormals, bool bTexCoords, GLTMESHDATA *pData);
+        static void FreeMeshData(GLTMESHDATA *pData);
+        void UploadMeshData(const GLTMESHDATA *pData);
+        void BeginUpload(GLTMESHDATA *pData);
+        bool UploadChunk(GLTMESHDATA *pData, size_t nMaxBytes);
+        void CancelUpload(void);
+        
+        // Draw - make sure you call glEnableClientState for these arrays
+        virtual void Draw(void);
+
+        // Many copies of the mesh in one draw call, for the *_INSTANCED stock
+        // shaders. Set the instances (after End() or a load, either of which
+        // drops the old ones) whenever they change, colors default to white.
+        // DrawInstanced() draws the first nInstances of them.
+        void SetInstanceData(GLuint nInstances, const M3DMatrix44f *pTransforms, const M3DVector4f *pColors = NULL);
+        void DrawInstanced(GLuint nInstances);
+        inline GLuint GetInstanceCount(void) { return nInstanceCount; }
+        
+    protected:
+        template<bool bNormals, bool bTexCoords>
+        bool IsSameVertex(GLuint iMatch, const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon);
+        template<bool bNormals, bool bTexCoords>
+        GLuint FindWeldMatch(const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon, GLuint nSearchStart);
+        template<bool bNormals, bool bTexCoords>
+        GLuint WeldVertex(const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon, GLuint nSearchStart);
+        GLuint WeldVertex(const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon, GLuint nSearchStart);
+        template<bool bNormals, bool bTexCoords>
+        void AddMesh(GLuint nVerts, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords,
+                     GLuint nIndexes, const GLuint *pMeshIndexes, float epsilon);
+        void AddMeshParallel(GLuint nVerts, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords,
+                             GLuint nIndexes, const GLuint *pMeshIndexes, float epsilon);
+        void DropMissingAttributes(const void *vNorms, const void *vTexCoords);
+        void AddToWeldHash(GLuint iVertex);
+        void FreeWeldHash(void);
+        void UploadIndexes(const void *pSrc, GLuint nSrcIndexSize);
+        void OptimizeVertexFetch(void);
+        void UploadPlanar(const GLvoid *pVertData, const GLvoid *pNormData, const GLvoid *pTexData);
+        void UploadInterleaved(void);
+        void UploadCompressed(GLuint nCompress);
+        void UploadMesh(const GLvoid *pIndexData, GLuint nIndexSize, const GLvoid *pVertData,
+                        const GLvoid *pNormData, const GLvoid *pTexData);
+        bool WriteBufferSection(FILE *pFile, GLuint buffer, size_t nBufferSize, size_t nOffset,
+                                size_t nStride, size_t nElementSize, GLuint nCount);
+        bool LoadMappedMesh(FILE *pFile, const GLTMESHHEADER &header, unsigned long long nEnd);
+        void SetFromHeader(const GLTMESHHEADER &header);
+        bool StreamSection(FILE *pFile, GLenum target, unsigned long long nSize, GLubyte *pChunk, size_t nChunkSize,
+                           GLuint nSrcIndexSize, GLuint nDestIndexSize, GLfloat *pMin, GLfloat *pMax);
+        void MarkLoaded(bool bNormals, bool bTexCoords);
+        void FreeBuffers(void);
+        void AttachInstanceData(void);
+
+        GLuint    *pIndexes = nullptr;         // Array of indexes
+        M3DVector3f *pVerts = nullptr;         // Array of vertices
+        M3DVector3f *pNorms = nullptr;         // Array of normals
+        M3DVector2f *pTexCoords = nullptr;     // Array of texture coordinates
+        
+        GLuint nMaxIndexes;         // Maximum workspace
+        GLuint nNumIndexes;         // Number of indexes currently used
+        GLuint nNumVerts;           // Number of vertices actually used
+        GLenum indexType;           // Smallest of byte/short/int that holds every index
+        
+        bool   bMadeStuff;
+        bool   bUploading;          // Buffers exist but aren't filled yet, see CancelUpload()
+        bool   bInterleaved;        // All attributes are in bufferObjects[VERTEX_DATA]
+        GLuint bufferObjects[4];
+        GLuint vertexArrayBufferObject;
+        GLfloat	boundingSphereRadius;
+        M3DVector3f vBoundsMin;     // Axis aligned bounding box
+        M3DVector3f vBoundsMax;
+        GLfloat fACMRBefore;
+        GLfloat fACMRAfter;
+
+        GLuint  nCompression;           // GLT_BATCH_COMPRESS_ flags End() used
+        M3DVector3f vPositionOffset;    // Compressed positions are offset + scale * (-1 to 1)
+        GLfloat fPositionScale;
+        GLTCOMPRESSIONREPORT compressionReport;
+
+        GLuint  uiInstanceBuffer;       // GLTINSTANCEDATA for each instance, 0 until SetInstanceData()
+        GLuint  nInstanceCount;
+        GLuint  uiInstanceVAO;          // Vertex array the instance attributes were set up in
+
+        // Weld hash. Vertices are binned into a grid of cells 2 * epsilon wide, and
+        // each hash bucket chains together the vertices that landed in it.
+        bool    bWeldHash = true;
+        GLuint  *pWeldBuckets = nullptr;    // First vertex in each bucket
+        GLuint  *pWeldNext = nullptr;       // Next vertex in the same bucket
+        GLuint  nWeldBuckets;               // Always a power of two
+        GLuint  nWeldHashed;                // Vertices [0, nWeldHashed) are in the hash
+        GLfloat fWeldEpsilon;               // Epsilon the grid was built for
+        GLuint  nWeldThreads;               // Threads for the bulk weld, 1 is serial
+    };
+
+
+#endif
@@ -1,22 +1,38 @@
-/*
- *  HalfFloat.h
- *
- *  Created by Richard Wright on 12/6/10.
- *  Copyright 2010-2023 Starstone Software Systems, Inc. All rights reserved.
- *
- */
-
-// -15 stored using a single precision bias of 127 
-const unsigned int HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP = 0x38000000; 
-
-// max exponent value in single precision that will be converted 
-// to Inf or Nan when stored as a half-float 
-const unsigned int HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP = 0x47800000;
-// 255 is the max exponent biased value 
-const unsigned int FLOAT_MAX_BIASED_EXP = (0xFF << 23);
-
-const unsigned int HALF_FLOAT_MAX_BIASED_EXP = (0x1F << 10); 
-typedef unsigned short	hfloat;
-
-hfloat convertFloatToHFloat(float *f);
-float convertHFloatToFloat(hfloat hf);
+/*
+ *  HalfFloat.h
+ *
+ *  Created by Richard Wright on 12/6/10.
+ *  Copyright 2010-2023 Starstone Software Systems, Inc. All rights reserved.
+ *
+ */
+
+#ifndef __GLT_HALF_FLOAT
+#define __GLT_HALF_FLOAT
+
+#include <stddef.h>
+
+// -15 stored using a single precision bias of 127 
+const unsigned int HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP = 0x38000000; 
+
+// max exponent value in single precision that will be converted 
+// to Inf or Nan when stored as a half-float 
+const unsigned int HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP = 0x47800000;
+// 255 is the max exponent biased value 
+const unsigned int FLOAT_MAX_BIASED_EXP = (0xFF << 23);
+
+const unsigned int HALF_FLOAT_MAX_BIASED_EXP = (0x1F << 10); 
+typedef unsigned short	hfloat;
+
+// One value at a time. Too small for a half goes to zero, or to a denormal
+// if it fits in one. Too big is Inf, and every NaN comes out as 0x7fff (or
+// 0xffff). See tools/HalfFloatCheck.cpp for how this differs from before.
+hfloat convertFloatToHFloat(float *f);
+float convertHFloatToFloat(hfloat hf);
+
+// Whole arrays at once. These use F16C or SSE2 if the CPU has them (checked
+// at run time), and round to nearest even like the hardware does. The single
+// value functions above truncate, so results can differ in the last bit.
+void convertFloatToHFloatN(const float *pSrc, hfloat *pDst, size_t nCount);
+void convertHFloatToFloatN(const hfloat *pSrc, float *pDst, size_t nCount);
+
+#endif
@@ -0,0 +1,261 @@
+/*
+ *  GLAssetManager.cpp
+ *
+
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list 
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
+to endorse or promote products derived from this software without specific prior 
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GLTools.h"
+#include "GLAssetManager.h"
+#include <chrono>
+
+
+/////////////////////////////////////////////////////////////////
+// Start the worker threads, they sleep until there is something to read
+GLAssetManager::GLAssetManager(GLuint nThreads, size_t nBudget)
+    {
+    pUploading = nullptr;
+    nNextID = 1;
+    nPending = 0;
+    nMemoryBudget = nBudget;
+    nMemoryInUse = 0;
+    nUploadChunk = GLT_ASSET_UPLOAD_CHUNK;
+    bQuit = false;
+
+    if(nThreads == 0)
+        nThreads = std::thread::hardware_concurrency();
+    if(nThreads == 0)
+        nThreads = 1;
+
+    for(GLuint i = 0; i < nThreads; i++)
+        threads.push_back(std::thread(&GLAssetManager::ReadThread, this));
+    }
+
+/////////////////////////////////////////////////////////////////
+// Anything not finished is thrown away. The batches are left as they were,
+// except one that was part way through uploading, which is left empty.
+GLAssetManager::~GLAssetManager(void)
+    {
+        {
+        std::lock_guard<std::mutex> lock(assetMutex);
+        bQuit = true;
+        }
+    workReady.notify_all();
+    memoryFreed.notify_all();
+
+    for(size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    while(!readQueue.empty()) {
+        delete readQueue.top();
+        readQueue.pop();
+        }
+
+    while(!uploadQueue.empty()) {
+        GLTriangleBatch::FreeMeshData(&uploadQueue.top()->data);
+        delete uploadQueue.top();
+        uploadQueue.pop();
+        }
+
+    if(pUploading) {
+        pUploading->pBatch->CancelUpload();
+        GLTriangleBatch::FreeMeshData(&pUploading->data);
+        delete pUploading;
+        }
+    }
+
+/////////////////////////////////////////////////////////////////
+// Queue up a mesh. Nothing happens to the batch on this thread until Update().
+GLuint GLAssetManager::LoadMesh(GLTriangleBatch *pBatch, const char *szFileName, int nPriority,
+                                GLT_ASSET_CALLBACK pCallback, void *pUserData, bool bNormals, bool bTexCoords)
+    {
+    ASSET *pAsset = new ASSET;
+    pAsset->nPriority = nPriority;
+    pAsset->pBatch = pBatch;
+    pAsset->fileName = szFileName;
+    pAsset->bNormals = bNormals;
+    pAsset->bTexCoords = bTexCoords;
+    pAsset->pCallback = pCallback;
+    pAsset->pUserData = pUserData;
+    pAsset->bOK = false;
+    pAsset->nMemory = 0;
+    memset(&pAsset->data, 0, sizeof(GLTMESHDATA));
+
+        {
+        std::lock_guard<std::mutex> lock(assetMutex);
+        pAsset->nID = nNextID++;
+        statusTable[pAsset->nID] = GLT_ASSET_QUEUED;
+        readQueue.push(pAsset);
+        nPending++;
+        }
+    workReady.notify_one();
+
+    return pAsset->nID;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Worker thread. Take the most important file, wait for room in the budget,
+// and read it into memory for the GL thread.
+void GLAssetManager::ReadThread(void)
+    {
+    std::unique_lock<std::mutex> lock(assetMutex);
+
+    for(;;) {
+        workReady.wait(lock, [this] { return bQuit || !readQueue.empty(); });
+        if(bQuit)
+            return;
+
+        ASSET *pAsset = readQueue.top();
+        readQueue.pop();
+        statusTable[pAsset->nID] = GLT_ASSET_READING;
+        lock.unlock();
+
+        // The file size is close enough to what it will take
+        FILE *pFile = fopen(pAsset->fileName.c_str(), "rb");
+        size_t nEstimate = 0;
+        if(pFile) {
+            fseek(pFile, 0, SEEK_END);
+            long nSize = ftell(pFile);
+            nEstimate = (nSize > 0) ? (size_t)nSize : 0;
+            fseek(pFile, 0, SEEK_SET);
+            }
+
+        // Something too big for the budget can still go when nothing else is waiting
+        lock.lock();
+        memoryFreed.wait(lock, [this, nEstimate] { return bQuit || nMemoryInUse == 0 || nMemoryInUse + nEstimate <= nMemoryBudget; });
+        if(bQuit) {
+            if(pFile)
+                fclose(pFile);
+            delete pAsset;
+            return;
+            }
+        nMemoryInUse += nEstimate;
+        lock.unlock();
+
+        if(pFile) {
+            pAsset->bOK = GLTriangleBatch::ReadMeshData(pFile, pAsset->bNormals, pAsset->bTexCoords, &pAsset->data);
+            fclose(pFile);
+            }
+
+        // Now we know exactly
+        for(int i = 0; i < 4; i++)
+            if(pAsset->data.pSections[i])
+                pAsset->nMemory += (size_t)pAsset->data.header.sectionSize[i];
+
+        lock.lock();
+        nMemoryInUse = nMemoryInUse - nEstimate + pAsset->nMemory;
+        uploadQueue.push(pAsset);
+        if(pAsset->nMemory < nEstimate)
+            memoryFreed.notify_all();
+        }
+    }
+
+/////////////////////////////////////////////////////////////////
+// Done with an asset one way or the other. GL thread only.
+void GLAssetManager::Finish(ASSET *pAsset, GLT_ASSET_STATUS status)
+    {
+    GLTriangleBatch::FreeMeshData(&pAsset->data);
+
+        {
+        std::lock_guard<std::mutex> lock(assetMutex);
+        if(pAsset->pCallback)
+            statusTable.erase(pAsset->nID);
+        else
+            statusTable[pAsset->nID] = status;
+        nMemoryInUse -= pAsset->nMemory;
+        nPending--;
+        }
+    memoryFreed.notify_all();
+
+    if(pAsset->pCallback)
+        pAsset->pCallback(pAsset->nID, status, pAsset->pUserData);
+
+    delete pAsset;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Upload whatever has been read, most important first, until time is up.
+// Must be called on the thread with the OpenGL context.
+void GLAssetManager::Update(double dMilliseconds)
+    {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    do {
+        if(pUploading == nullptr) {
+            ASSET *pAsset;
+                {
+                std::lock_guard<std::mutex> lock(assetMutex);
+                if(uploadQueue.empty())
+                    return;
+
+                pAsset = uploadQueue.top();
+                uploadQueue.pop();
+                if(pAsset->bOK)
+                    statusTable[pAsset->nID] = GLT_ASSET_UPLOADING;
+                }
+
+            if(!pAsset->bOK) {
+                Finish(pAsset, GLT_ASSET_FAILED);
+                continue;
+                }
+
+            pAsset->pBatch->BeginUpload(&pAsset->data);
+            pUploading = pAsset;
+            }
+
+        if(pUploading->pBatch->UploadChunk(&pUploading->data, nUploadChunk)) {
+            Finish(pUploading, GLT_ASSET_READY);
+            pUploading = nullptr;
+            }
+        }
+    while(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() < dMilliseconds);
+    }
+
+/////////////////////////////////////////////////////////////////
+GLT_ASSET_STATUS GLAssetManager::GetStatus(GLuint nAsset)
+    {
+    std::lock_guard<std::mutex> lock(assetMutex);
+    std::map<GLuint, GLT_ASSET_STATUS>::iterator it = statusTable.find(nAsset);
+    if(it == statusTable.end())
+        return GLT_ASSET_INVALID;
+
+    // Nothing more will happen to this one
+    GLT_ASSET_STATUS status = it->second;
+    if(status == GLT_ASSET_READY || status == GLT_ASSET_FAILED)
+        statusTable.erase(it);
+
+    return status;
+    }
+
+GLuint GLAssetManager::GetPendingCount(void)
+    {
+    std::lock_guard<std::mutex> lock(assetMutex);
+    return nPending;
+    }
+
+size_t GLAssetManager::GetMemoryInUse(void)
+    {
+    std::lock_guard<std::mutex> lock(assetMutex);
+    return nMemoryInUse;
+    }
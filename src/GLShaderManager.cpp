@@ -1,860 +1,1626 @@
-/* GLShaderManager.h
-
-Copyright (c) 2009-2023, Richard S. Wright Jr.
-All rights reserved.
-
-Redistribution and use in source, with or without modification,
-are permitted provided that the following conditions are met:
-
-Redistributions of source code must retain the above copyright notice, this list
-of conditions and the following disclaimer.
-
-Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
-to endorse or promote products derived from this software without specific prior
-written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
-EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
-OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
-SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
-INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
-TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
-BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
-CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
-ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#include "GLTools.h"
-#include "GLShaderManager.h"
-
-
-///////////////////////////////////////////////////////////////////////////////
-// Stock Shader Source Code
-///////////////////////////////////////////////////////////////////////////////
-
-///////////////////////////////////////////////////////////////////////////////
-// Identity Shader (GLT_SHADER_IDENTITY)
-// This shader does no transformations at all, and uses the current
-// glColor value for fragments.
-// It will shade between verticies.
-static const char *szIdentityShaderVP =
-#ifndef OPENGL_ES
-                                        "#version 400\r\n"
-#else
-                                        "#version 300 es\r\n"
-#endif
-                                        "in vec4 vVertex;"
-                                        "void main(void) "
-                                        "{ gl_Position = vVertex; "
-                                        "}";
-
-static const char *szIdentityShaderFP =
-#ifndef OPENGL_ES
-                                        "#version 400\r\n"
-#else
-                                        "#version 300 es\r\n"
-#endif
-                                        "precision mediump float;"
-                                        "out vec4 vFragmentColor;"
-                                        "uniform vec4 vColor;"
-                                        "void main(void) "
-                                        "{ vFragmentColor = vColor;"
-                                        "}";
-
-
-///////////////////////////////////////////////////////////////////////////////
-// Flat Shader (GLT_SHADER_FLAT)
-// This shader applies the given model view matrix to the verticies,
-// and uses a uniform color value.
-static const char *szFlatShaderVP =
-#ifndef OPENGL_ES
-                                    "#version 400\r\n"
-#else
-                                    "#version 300 es\r\n"
-
-#endif
-                                    "precision mediump float;"
-                                    "uniform mat4 mvpMatrix;"
-                                    "in vec4 vVertex;"
-                                    "void main(void) "
-                                    "{ gl_Position = mvpMatrix * vVertex; "
-                                    "}";
-
-static const char *szFlatShaderFP =
-#ifndef OPENGL_ES
-                                            "#version 400\r\n"
-#else
-                                            "#version 300 es\r\n"
-
-#endif
-                                    "precision mediump float;"
-                                    "out vec4 vFragmentColor;"
-                                    "uniform vec4 vColor;"
-                                    "void main(void) "
-                                    "{ vFragmentColor = vColor; "
-                                    "}";
-
-
-///////////////////////////////////////////////////////////////////////////////
-// GLT_SHADER_SHADED
-// Point light, diffuse lighting only
-static const char *szShadedVP =
-#ifndef OPENGL_ES
-                                    "#version 400\r\n"
-#else
-                                    "#version 300 es\r\n"
-#endif
-                                    "uniform mat4 mvpMatrix;"
-                                    "in vec4 vColor;"
-                                    "in vec4 vVertex;"
-                                    "out vec4 vFragColor;"
-                                    "void main(void) {"
-                                    "vFragColor = vColor; "
-                                    " gl_Position = mvpMatrix * vVertex; "
-                                    "}";
-
-static const char *szShadedFP =
-        #ifndef OPENGL_ES
-                                            "#version 400\r\n"
-        #else
-                                            "#version 300 es\r\n"
-
-        #endif
-                                    "precision mediump float;"
-                                    "out vec4 vFragmentColor;"
-                                    "in vec4 vFragColor; "
-                                    "void main(void) { "
-                                    " vFragmentColor = vFragColor; "
-#ifndef OPENGL_ES
-                                        " if(vFragmentColor.a == 0.0) discard;"
-#endif
-                                    "}";
-
-// GLT_SHADER_DEFAULT_LIGHT
-// Simple diffuse, directional, and vertex based light
-static const char *szDefaultLightVP =
-#ifndef OPENGL_ES
-                                    "#version 400\r\n"
-#else
-                                     "#version 300 es\r\n"
-
-#endif
-                                      "uniform mat4 mvMatrix;"
-                                      "uniform mat4 pMatrix;"
-                                      "out vec4 vFragColor;"
-                                      "in vec4 vVertex;"
-                                      "in vec3 vNormal;"
-                                      "uniform vec4 vColor;"
-                                      "void main(void) { "
-                                      " mat3 mNormalMatrix;"
-                                      " mNormalMatrix[0] = normalize(mvMatrix[0].xyz);"
-                                      " mNormalMatrix[1] = normalize(mvMatrix[1].xyz);"
-                                      " mNormalMatrix[2] = normalize(mvMatrix[2].xyz);"
-                                      " vec3 vNorm = normalize(mNormalMatrix * normalize(vNormal));"
-                                      " vec3 vLightDir = vec3(0.0, 0.0, 1.0); "
-                                      " float fDot = max(0.0, dot(vNorm, vLightDir)); "
-                                      " vFragColor.rgb = vColor.rgb * fDot;"
-                                      " vFragColor.a = vColor.a;"
-                                      " mat4 mvpMatrix;"
-                                      " mvpMatrix = pMatrix * mvMatrix;"
-                                      " gl_Position = mvpMatrix * vVertex; "
-                                      "}";
-
-
-static const char *szDefaultLightFP =
- #ifndef OPENGL_ES
-                                            "#version 400\r\n"
- #else
-                                        "#version 300 es\r\n"
-
- #endif
-                                        "precision mediump float;"
-                                        "out vec4 vFragmentColor;"
-                                        "in vec4 vFragColor; "
-                                        "void main(void) { "
-                                        " vFragmentColor = vFragColor; "
-                                        "}";
-
-//GLT_SHADER_POINT_LIGHT_DIFF
-// Point light, diffuse lighting only
-static const char *szPointLightDiffVP =
-#ifndef OPENGL_ES
-                                          "#version 400\r\n"
-#else
-        "#version 300 es\r\n"
-#endif
-                                          "uniform mat4 mvMatrix;"
-                                          "uniform mat4 pMatrix;"
-                                          "uniform vec3 vLightPos;"
-                                          "uniform vec4 vColor;"
-                                          "in vec4 vVertex;"
-                                          "in vec3 vNormal;"
-                                          "out vec4 vFragColor;"
-                                          "void main(void) { "
-                                          " mat3 mNormalMatrix;"
-                                          " mNormalMatrix[0] = normalize(mvMatrix[0].xyz);"
-                                          " mNormalMatrix[1] = normalize(mvMatrix[1].xyz);"
-                                          " mNormalMatrix[2] = normalize(mvMatrix[2].xyz);"
-                                          " vec3 vNorm = normalize(mNormalMatrix * vNormal);"
-                                          " vec4 ecPosition;"
-                                          " vec3 ecPosition3;"
-                                          " ecPosition = mvMatrix * vVertex;"
-                                          " ecPosition3 = ecPosition.xyz /ecPosition.w;"
-                                          " vec3 vLightDir = normalize(vLightPos - ecPosition3);"
-                                          " float fDot = max(0.0, dot(vNorm, vLightDir)); "
-                                          " vFragColor.rgb = vColor.rgb * fDot;"
-                                          " vFragColor.a = vColor.a;"
-                                          " mat4 mvpMatrix;"
-                                          " mvpMatrix = pMatrix * mvMatrix;"
-                                          " gl_Position = mvpMatrix * vVertex; "
-                                          "}";
-
-
-static const char *szPointLightDiffFP =
-        #ifndef OPENGL_ES
-                                            "#version 400\r\n"
-        #else
-                                            "#version 300 es\r\n"
-
-        #endif
-                                        "precision mediump float;"
-                                        "out vec4 vFragmentColor;"
-                                        "in vec4 vFragColor; "
-                                        "void main(void) { "
-                                        " vFragmentColor = vFragColor; "
-                                        "}";
-
-//GLT_SHADER_TEXTURE_REPLACE
-// Just put the texture on the polygons
-static const char *szTextureReplaceVP =
-#ifndef OPENGL_ES
-                                        "#version 400\r\n"
-#else
-                                        "#version 300 es\r\n"
-#endif
-                                        "uniform mat4 mvpMatrix;"
-                                        "in vec4 vVertex;"
-                                        "in vec2 vTexCoord0;"
-                                        "out vec2 vTex;"
-                                        "void main(void) "
-                                        "{ vTex = vTexCoord0;"
-                                        " gl_Position = mvpMatrix * vVertex; "
-                                        "}";
-
-static const char *szTextureReplaceFP =
-        #ifndef OPENGL_ES
-                                            "#version 400\r\n"
-        #else
-                                            "#version 300 es\r\n"
-
-        #endif
-                                        "precision mediump float;"
-                                        "out vec4 vFragColor;"
-                                        "in vec2 vTex;"
-                                        "uniform sampler2D textureUnit0;"
-                                        "void main(void) "
-                                        "{ "
-                                        "vFragColor = texture(textureUnit0, vTex);"
-                                        "}";
-
-
-
-//GLT_SHADER_TEXTURE_MODULATE
-// Just put the texture on the polygons, but multiply by the color (as a unifomr)
-static const char *szTextureModulateVP =
-#ifndef OPENGL_ES
-                                        "#version 400\r\n"
-#else
-        "#version 300 es\r\n"
-#endif
-                                        "uniform mat4 mvpMatrix;"
-                                        "in vec4 vVertex;"
-                                        "in vec2 vTexCoord0;"
-                                        "out vec2 vTex;"
-                                        "void main(void) "
-                                        "{ vTex = vTexCoord0;"
-                                        " gl_Position = mvpMatrix * vVertex; "
-                                        "}";
-
-static const char *szTextureModulateFP =
-        #ifndef OPENGL_ES
-                                            "#version 400\r\n"
-        #else
-                                            "#version 300 es\r\n"
-        #endif
-                                        "precision mediump float;"
-                                        "out vec4 vFragmentColor;"
-                                        "in vec2 vTex;"
-                                        "uniform sampler2D textureUnit0;"
-                                        "uniform vec4 vColor;"
-                                        "void main(void) "
-                                        "{ vFragmentColor = vColor * texture(textureUnit0, vTex); "
-                                        "}";
-
-
-
-
-//GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF
-// Point light (Diffuse only), with texture (modulated)
-static const char *szTexturePointLightDiffVP =
-#ifndef OPENGL_ES
-                                                 "#version 400\r\n"
-#else
-        "#version 300 es\r\n"
-#endif
-                                                  "uniform mat4 mvMatrix;"
-                                                  "uniform mat4 pMatrix;"
-                                                  "uniform vec3 vLightPos;"
-                                                  "uniform vec4 vColor;"
-                                                  "in vec4 vVertex;"
-                                                  "in vec3 vNormal;"
-                                                  "out vec4 vFragColor;"
-                                                  "in vec2 vTexCoord0;"
-                                                  "out vec2 vTex;"
-                                                  "void main(void) { "
-                                                  " mat3 mNormalMatrix;"
-                                                  " mNormalMatrix[0] = normalize(mvMatrix[0].xyz);"
-                                                  " mNormalMatrix[1] = normalize(mvMatrix[1].xyz);"
-                                                  " mNormalMatrix[2] = normalize(mvMatrix[2].xyz);"
-                                                  " vec3 vNorm = normalize(mNormalMatrix * vNormal);"
-                                                  " vec4 ecPosition;"
-                                                  " vec3 ecPosition3;"
-                                                  " ecPosition = mvMatrix * vVertex;"
-                                                  " ecPosition3 = ecPosition.xyz /ecPosition.w;"
-                                                  " vec3 vLightDir = normalize(vLightPos - ecPosition3);"
-                                                  " float fDot = max(0.0, dot(vNorm, vLightDir)); "
-                                                  " vFragColor.rgb = (vColor.rgb * fDot);"
-                                                  " vFragColor.a = vColor.a;"
-                                                  " vTex = vTexCoord0;"
-                                                  " mat4 mvpMatrix;"
-                                                  " mvpMatrix = pMatrix * mvMatrix;"
-                                                  " gl_Position = mvpMatrix * vVertex; "
-                                                  "}";
-
-
-static const char *szTexturePointLightDiffFP =
-        #ifndef OPENGL_ES
-                                            "#version 400\r\n"
-        #else
-                                            "#version 300 es\r\n"
-
-        #endif
-                                                "precision mediump float;"
-                                                "out vec4 vFragmentColor;"
-                                                "in vec4 vFragColor;"
-                                                "in vec2 vTex;"
-                                                "uniform sampler2D textureUnit0;"
-                                                "void main(void) { "
-                                                " vFragmentColor = vFragColor * texture(textureUnit0, vTex);"
-                                                "}";
-
-
-
-
-
-// GLT_SHADER_POINT_SPRITES
-// Draws point sprites of a given size and color. Custom texture coordinates are required, as they are generally a lookup.
-static const char *szPointSpriteVP =
-#ifndef OPENGL_ES
-                                        "#version 400\r\n"
-#else
-        "#version 300 es\r\n"
-#endif
-                                        "uniform mat4 mvpMatrix;"
-                                        "in vec4 vVertex;"   // XYZ, and size
-                                        "in vec4 vTexCoord0;"
-                                        "in vec4 vColor;"
-                                        "out vec4 vTex;"
-                                        "out vec4 vPointColor;"
-                                        "void main(void) "
-                                        "{ vTex = vTexCoord0;"  // Pass through
-                                        "  vPointColor = vColor;"
-                                        "  gl_PointSize = vVertex.w;"
-                                        " gl_Position = mvpMatrix * vec4(vVertex.xyz, 1.0); "
-                                        "}";
-
-static const char *szPointSpriteFP =
-        #ifndef OPENGL_ES
-                                            "#version 400\r\n"
-        #else
-                                            "#version 300 es\r\n"
-
-        #endif
-                                        "precision mediump float;"
-                                        "out vec4 vFragmentColor;"
-                                        "in vec4 vTex;"
-                                        "in vec4 vPointColor;"
-                                        "uniform sampler2D textureUnit0;"
-
-                                        "void main(void) "
-                                        " { vec2 vTexCoord;"
-                                        "   float w = gl_PointCoord.s * vTex.z;"    // Width scaled to texture cell width
-                                        "   float h = gl_PointCoord.t * vTex.w;"    // Height scaled to texture cell height
-                                        "   vTexCoord.x = vTex.x + w; "
-                                        "   vTexCoord.y = vTex.y + h; "
-                                        "   vFragmentColor = vPointColor * texture(textureUnit0, vTexCoord); "
-                                        "}";
-
-
-
-// GLT_SHADER_POINT_SPRITES_PLAIN
-// Draws point sprites of a given size and color. No texture.
-static const char *szPointSpritePlainVP =
-#ifndef OPENGL_ES
-                                        "#version 400\r\n"
-#else
-                                        "#version 300 es\r\n"
-#endif
-                                        "uniform mat4 mvpMatrix;"
-                                        "in vec4 vVertex;"   // XYZ, and size
-                                        "in vec4 vColor;"
-                                        "out vec4 vPointColor;"
-                                        "void main(void) "
-                                        "{ "
-                                        "  vPointColor = vec4(vColor.rgb, 1.0);"
-                                        "  gl_PointSize = vColor.w;"
-                                        " gl_Position = mvpMatrix * vec4(vVertex.xyz, 1.0); "
-                                        "}";
-
-static const char *szPointSpritePlainFP =
-        #ifndef OPENGL_ES
-                                            "#version 400\r\n"
-        #else
-                                            "#version 300 es\r\n"
-
-        #endif
-                                        "precision mediump float;"
-                                        "out vec4 vFragmentColor;"
-                                        "in vec4 vPointColor;"
-
-                                        "void main(void) "
-                                        " { "
-                                        " if(length(gl_PointCoord.st - vec2(0.5)) > 0.5)"
-                                        "     discard;"
-                                        "vFragmentColor = vPointColor; "
-                                        "}";
-
-
-
-
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// Constructor, just zero out everything
-GLShaderManager::GLShaderManager(void)
-    {
-    // Set stock shader handles to 0... uninitialized
-    for(unsigned int i = 0; i < GLT_SHADER_LAST; i++)
-        uiStockShaders[i] = 0;
-    }
-
-///////////////////////////////////////////////////////////////////////////////
-GLShaderManager::~GLShaderManager(void)
-    {
-    }
-
-
-void GLShaderManager::freeGL(void)
-    {
-    // Stock shaders is the general (are you initialized test)
-    if(uiStockShaders[0] != 0) {
-        unsigned int i;
-        for(i = 0; i < GLT_SHADER_LAST; i++)
-            glDeleteProgram(uiStockShaders[i]);
-        }
-    }
-
-
-///////////////////////////////////////////////////////////////////////////////
-// Initialize and load the stock shaders
-bool GLShaderManager::InitializeStockShaders(void)
-    {
-#ifdef QT_IS_AVAILABLE
-    initializeOpenGLFunctions();
-#endif
-
-    uiStockShaders[GLT_SHADER_IDENTITY]			= GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szIdentityShaderVP, szIdentityShaderFP, 1, GLT_ATTRIBUTE_VERTEX, "vVertex");
-    uiStockShaders[GLT_SHADER_FLAT]				= GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szFlatShaderVP, szFlatShaderFP, 1, GLT_ATTRIBUTE_VERTEX, "vVertex");
-
-    uiStockShaders[GLT_SHADER_SHADED]			= GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szShadedVP, szShadedFP, 2,
-                                                                                                GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_COLOR, "vColor");
-
-
-    uiStockShaders[GLT_SHADER_DEFAULT_LIGHT]	= GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szDefaultLightVP, szDefaultLightFP, 2,
-                                                                                                GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_NORMAL, "vNormal");
-
-    uiStockShaders[GLT_SHADER_POINT_LIGHT_DIFF] = GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szPointLightDiffVP, szPointLightDiffFP, 2,
-                                                                                                GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_NORMAL, "vNormal");
-
-    uiStockShaders[GLT_SHADER_TEXTURE_REPLACE]  = GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szTextureReplaceVP, szTextureReplaceFP, 2,
-                                                                                                GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_TEXTURE0, "vTexCoord0");
-
-    uiStockShaders[GLT_SHADER_TEXTURE_MODULATE] = GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szTextureModulateVP, szTextureModulateFP, 2,
-                                                        GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_TEXTURE0, "vTexCoord0");
-
-    uiStockShaders[GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF] = GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szTexturePointLightDiffVP, szTexturePointLightDiffFP, 3,
-                                                                GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_NORMAL, "vNormal", GLT_ATTRIBUTE_TEXTURE0, "vTexCoord0");
-
-
-    uiStockShaders[GLT_SHADER_POINT_SPRITES] = GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szPointSpriteVP, szPointSpriteFP, 3,
-                                                                GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_COLOR, "vColor", GLT_ATTRIBUTE_TEXTURE0, "vTexCoord0");
-
-    uiStockShaders[GLT_POINT_SPRITES_PLAIN] = GLTools::GetGLTools()->gltLoadShaderPairSrcWithAttributes(szPointSpritePlainVP, szPointSpritePlainFP, 2,
-                                                                GLT_ATTRIBUTE_VERTEX, "vVertex", GLT_ATTRIBUTE_COLOR, "vColor");
-
-    // if any shader failed to build, return false
-    for(int shader = GLT_SHADER_IDENTITY; shader < GLT_SHADER_LAST; shader++)
-        if(uiStockShaders[shader] == 0)
-            return false;
-
-    return true;
-    }
-
-
-///////////////////////////////////////////////////////////////////////
-// Use a specific stock shader, and set the appropriate uniforms
-GLint GLShaderManager::UseStockShader(int nShaderID, ...)
-    {
-    // Check for out of bounds
-    if(nShaderID >= GLT_SHADER_LAST)
-        return -1;
-
-    // List of uniforms
-    va_list uniformList;
-    va_start(uniformList, nShaderID);
-
-    // Bind to the correct shader
-    glUseProgram(uiStockShaders[nShaderID]);
-
-    // Set up the uniforms
-    GLint iTransform, iModelMatrix, iProjMatrix, iColor, iLight, iTextureUnit;
-    int				iInteger;
-    M3DMatrix44f* mvpMatrix;
-    M3DMatrix44f*  pMatrix;
-    M3DMatrix44f*  mvMatrix;
-    M3DVector4f*  vColor;
-    M3DVector3f*  vLightPos;
-
-
-    switch(nShaderID)
-        {
-        case GLT_SHADER_FLAT:			// Just the modelview projection matrix and the color
-            iTransform = glGetUniformLocation(uiStockShaders[nShaderID], "mvpMatrix");
-            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iTransform, 1, GL_FALSE, *mvpMatrix);
-
-            iColor = glGetUniformLocation(uiStockShaders[nShaderID], "vColor");
-            vColor = va_arg(uniformList, M3DVector4f*);
-            glUniform4fv(iColor, 1, *vColor);
-            break;
-
-    case GLT_SHADER_TEXTURE_REPLACE:	// Just the texture place
-            iTransform = glGetUniformLocation(uiStockShaders[nShaderID], "mvpMatrix");
-            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iTransform, 1, GL_FALSE, *mvpMatrix);
-
-            iTextureUnit = glGetUniformLocation(uiStockShaders[nShaderID], "textureUnit0");
-            iInteger = va_arg(uniformList, int);
-            glUniform1i(iTextureUnit, iInteger);
-            break;
-
-        case GLT_SHADER_TEXTURE_MODULATE: // Multiply the texture by the geometry color
-            iTransform = glGetUniformLocation(uiStockShaders[nShaderID], "mvpMatrix");
-            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iTransform, 1, GL_FALSE, *mvpMatrix);
-
-            iColor = glGetUniformLocation(uiStockShaders[nShaderID], "vColor");
-            vColor = va_arg(uniformList, M3DVector4f*);
-            glUniform4fv(iColor, 1, *vColor);
-
-            iTextureUnit = glGetUniformLocation(uiStockShaders[nShaderID], "textureUnit0");
-            iInteger = va_arg(uniformList, int);
-            glUniform1i(iTextureUnit, iInteger);
-            break;
-
-        case GLT_SHADER_POINT_SPRITES:
-            iTransform = glGetUniformLocation(uiStockShaders[nShaderID], "mvpMatrix");
-            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iTransform, 1, GL_FALSE, *mvpMatrix);
-
-            iTextureUnit = glGetUniformLocation(uiStockShaders[nShaderID], "textureUnit0");
-            iInteger = va_arg(uniformList, int);
-            glUniform1i(iTextureUnit, iInteger);
-            break;
-
-        case GLT_POINT_SPRITES_PLAIN:
-            iTransform = glGetUniformLocation(uiStockShaders[nShaderID], "mvpMatrix");
-            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iTransform, 1, GL_FALSE, *mvpMatrix);
-            break;
-
-        case GLT_SHADER_DEFAULT_LIGHT:
-            iModelMatrix = glGetUniformLocation(uiStockShaders[nShaderID], "mvMatrix");
-            mvMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iModelMatrix, 1, GL_FALSE, *mvMatrix);
-
-            iProjMatrix = glGetUniformLocation(uiStockShaders[nShaderID], "pMatrix");
-            pMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iProjMatrix, 1, GL_FALSE, *pMatrix);
-
-            iColor = glGetUniformLocation(uiStockShaders[nShaderID], "vColor");
-            vColor = va_arg(uniformList, M3DVector4f*);
-            glUniform4fv(iColor, 1, *vColor);
-            break;
-
-        case GLT_SHADER_POINT_LIGHT_DIFF:
-            iModelMatrix = glGetUniformLocation(uiStockShaders[nShaderID], "mvMatrix");
-            mvMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iModelMatrix, 1, GL_FALSE, *mvMatrix);
-
-            iProjMatrix = glGetUniformLocation(uiStockShaders[nShaderID], "pMatrix");
-            pMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iProjMatrix, 1, GL_FALSE, *pMatrix);
-
-            iLight = glGetUniformLocation(uiStockShaders[nShaderID], "vLightPos");
-            vLightPos = va_arg(uniformList, M3DVector3f*);
-            glUniform3fv(iLight, 1, *vLightPos);
-
-            iColor = glGetUniformLocation(uiStockShaders[nShaderID], "vColor");
-            vColor = va_arg(uniformList, M3DVector4f*);
-            glUniform4fv(iColor, 1, *vColor);
-            break;
-
-        case GLT_SHADER_SHADED:		// Just the modelview projection matrix. Color is an attribute
-            iTransform = glGetUniformLocation(uiStockShaders[nShaderID], "mvpMatrix");
-            pMatrix = va_arg(uniformList, M3DMatrix44f*);
-            glUniformMatrix4fv(iTransform, 1, GL_FALSE, *pMatrix);
-            break;
-
-        case GLT_SHADER_IDENTITY:	// Just the Color
-            iColor = glGetUniformLocation(uiStockShaders[nShaderID], "vColor");
-            vColor = va_arg(uniformList, M3DVector4f*);
-            glUniform4fv(iColor, 1, *vColor);
-        default:
-            break;
-        }
-    va_end(uniformList);
-
-    return uiStockShaders[nShaderID];
-    }
-
-
-///////////////////////////////////////////////////////////////////////////////
-// Load a shader pair from file. The shader pair root is added to the shader
-// lookup table and can be found again if necessary with LookupShader.
-GLuint GLShaderManager::LoadShaderPair(const char *szVertexProgFileName, const char *szFragProgFileName)
-    {
-    SHADERLOOKUPENTRY shaderEntry;
-
-    // Load shader and test for fail
-    shaderEntry.uiShaderID = GLTools::GetGLTools()->gltLoadShaderPair(szVertexProgFileName, szFragProgFileName);
-    if(shaderEntry.uiShaderID == 0)
-        return 0;
-
-    // Add to the table
-    strncpy(shaderEntry.szVertexShaderName, szVertexProgFileName, MAX_SHADER_NAME_LENGTH);
-    strncpy(shaderEntry.szFragShaderName, szFragProgFileName, MAX_SHADER_NAME_LENGTH);
-//	shaderTable.push_back(shaderEntry);
-    return shaderEntry.uiShaderID;
-    }
-
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Load shaders from source text. If the szName is NULL, just make it and return the handle
-// (useful for stock shaders). Otherwize, make sure it's not already there, then add to list
-GLuint GLShaderManager::LoadShaderPairSrc(const char *szName, const char *szVertexSrc, const char *szFragSrc)
-    {
-    // Just make it and return
-    if(szName == NULL)
-        return GLTools::GetGLTools()->gltLoadShaderPairSrc(szVertexSrc, szFragSrc);
-
-
-    // Ok, make it and add to table
-    SHADERLOOKUPENTRY shaderEntry;
-    shaderEntry.uiShaderID = GLTools::GetGLTools()->gltLoadShaderPairSrc(szVertexSrc, szFragSrc);
-    if(shaderEntry.uiShaderID == 0)
-        return 0;	// Game over, won't compile
-
-    // Add it...
-    strncpy(shaderEntry.szVertexShaderName, szName, MAX_SHADER_NAME_LENGTH);
-    strncpy(shaderEntry.szFragShaderName, szName, MAX_SHADER_NAME_LENGTH);
-//	shaderTable.push_back(shaderEntry);
-    return shaderEntry.uiShaderID;
-    }
-
-
-///////////////////////////////////////////////////////////////////////////////////////////////
-// Load the shader file, with the supplied named attributes
-GLuint GLShaderManager::LoadShaderPairWithAttributes(const char *szVertexProgFileName, const char *szFragmentProgFileName, ...)
-    {
-    SHADERLOOKUPENTRY shaderEntry;
-
-    // Temporary Shader objects
-    GLuint hVertexShader;
-    GLuint hFragmentShader;
-    GLint testVal;
-
-    // Create shader objects
-    hVertexShader = glCreateShader(GL_VERTEX_SHADER);
-    hFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-
-    // Load them. If fail clean up and return null
-    if(GLTools::GetGLTools()->gltLoadShaderFile(szVertexProgFileName, hVertexShader) == false)
-        {
-        glDeleteShader(hVertexShader);
-        glDeleteShader(hFragmentShader);
-        return 0;
-        }
-
-    if(GLTools::GetGLTools()->gltLoadShaderFile(szFragmentProgFileName, hFragmentShader) == false)
-        {
-        glDeleteShader(hVertexShader);
-        glDeleteShader(hFragmentShader);
-        return 0;
-        }
-
-    // Compile them
-    glCompileShader(hVertexShader);
-    glCompileShader(hFragmentShader);
-
-    // Check for errors
-    glGetShaderiv(hVertexShader, GL_COMPILE_STATUS, &testVal);
-    if(testVal == GL_FALSE)
-        {
-        glDeleteShader(hVertexShader);
-        glDeleteShader(hFragmentShader);
-        return 0;
-        }
-
-    glGetShaderiv(hFragmentShader, GL_COMPILE_STATUS, &testVal);
-    if(testVal == GL_FALSE)
-        {
-        glDeleteShader(hVertexShader);
-        glDeleteShader(hFragmentShader);
-        return 0;
-        }
-
-    // Link them - assuming it works...
-    shaderEntry.uiShaderID = glCreateProgram();
-    glAttachShader(shaderEntry.uiShaderID, hVertexShader);
-    glAttachShader(shaderEntry.uiShaderID, hFragmentShader);
-
-
-    // List of attributes
-    va_list attributeList;
-    va_start(attributeList, szFragmentProgFileName);
-
-    char *szNextArg;
-    int iArgCount = va_arg(attributeList, int);	// Number of attributes
-    for(int i = 0; i < iArgCount; i++)
-        {
-        int index = va_arg(attributeList, int);
-        szNextArg = va_arg(attributeList, char*);
-        glBindAttribLocation(shaderEntry.uiShaderID, index, szNextArg);
-        }
-
-    va_end(attributeList);
-
-    glLinkProgram(shaderEntry.uiShaderID);
-
-    // These are no longer needed
-    glDeleteShader(hVertexShader);
-    glDeleteShader(hFragmentShader);
-
-    // Make sure link worked too
-    glGetProgramiv(shaderEntry.uiShaderID, GL_LINK_STATUS, &testVal);
-    if(testVal == GL_FALSE)
-        {
-        glDeleteProgram(shaderEntry.uiShaderID);
-        return 0;
-        }
-
-
-    // Add it...
-    strncpy(shaderEntry.szVertexShaderName, szVertexProgFileName, MAX_SHADER_NAME_LENGTH);
-    strncpy(shaderEntry.szFragShaderName, szFragmentProgFileName, MAX_SHADER_NAME_LENGTH);
-//	shaderTable.push_back(shaderEntry);
-    return shaderEntry.uiShaderID;
-    }
-
-
-///////////////////////////////////////////////////////////////////////////////////////////////
-// Load the shader from source, with the supplied named attributes
-GLuint GLShaderManager::LoadShaderPairSrcWithAttributes(const char *szName, const char *szVertexProg, const char *szFragmentProg, ...)
-    {
-    SHADERLOOKUPENTRY shaderEntry;
-
-    // Temporary Shader objects
-    GLuint hVertexShader;
-    GLuint hFragmentShader;
-    GLint testVal;
-
-    // Create shader objects
-    hVertexShader = glCreateShader(GL_VERTEX_SHADER);
-    hFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-
-    // Load them.
-    GLTools::GetGLTools()->gltLoadShaderSrc(szVertexProg, hVertexShader);
-    GLTools::GetGLTools()->gltLoadShaderSrc(szFragmentProg, hFragmentShader);
-
-    // Compile them
-    glCompileShader(hVertexShader);
-    glCompileShader(hFragmentShader);
-
-    // Check for errors
-    glGetShaderiv(hVertexShader, GL_COMPILE_STATUS, &testVal);
-    if(testVal == GL_FALSE)
-        {
-        glDeleteShader(hVertexShader);
-        glDeleteShader(hFragmentShader);
-        return 0;
-        }
-
-    glGetShaderiv(hFragmentShader, GL_COMPILE_STATUS, &testVal);
-    if(testVal == GL_FALSE)
-        {
-        glDeleteShader(hVertexShader);
-        glDeleteShader(hFragmentShader);
-        return 0;
-        }
-
-    // Link them - assuming it works...
-    shaderEntry.uiShaderID = glCreateProgram();
-    glAttachShader(shaderEntry.uiShaderID, hVertexShader);
-    glAttachShader(shaderEntry.uiShaderID, hFragmentShader);
-
-    // List of attributes
-    va_list attributeList;
-    va_start(attributeList, szFragmentProg);
-
-    char *szNextArg;
-    int iArgCount = va_arg(attributeList, int);	// Number of attributes
-    for(int i = 0; i < iArgCount; i++)
-        {
-        int index = va_arg(attributeList, int);
-        szNextArg = va_arg(attributeList, char*);
-        glBindAttribLocation(shaderEntry.uiShaderID, index, szNextArg);
-        }
-    va_end(attributeList);
-
-
-    glLinkProgram(shaderEntry.uiShaderID);
-
-    // These are no longer needed
-    glDeleteShader(hVertexShader);
-    glDeleteShader(hFragmentShader);
-
-    // Make sure link worked too
-    glGetProgramiv(shaderEntry.uiShaderID, GL_LINK_STATUS, &testVal);
-    if(testVal == GL_FALSE)
-        {
-        glDeleteProgram(shaderEntry.uiShaderID);
-        return 0;
-        }
-
-    // Add it...
-    strncpy(shaderEntry.szVertexShaderName, szName, MAX_SHADER_NAME_LENGTH);
-    strncpy(shaderEntry.szFragShaderName, szName, MAX_SHADER_NAME_LENGTH);
-//	shaderTable.push_back(shaderEntry);
-    return shaderEntry.uiShaderID;
-    }
+/* GLShaderManager.h
+
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "GLTools.h"
+#include "GLShaderManager.h"
+#include "GLStateCache.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Stock Shader Source Code
+///////////////////////////////////////////////////////////////////////////////
+
+// The uniform blocks shared by the stock shaders. Per frame data (projection
+// and light) and per draw data (matrices and color) are separate, so the
+// per frame block only changes when it has to. These must match the
+// GLTFRAMEBLOCK and GLTOBJECTBLOCK structures (std140 layout). Members are
+// all highp, because the vertex and fragment declarations must agree on ES.
+#define GLT_FRAME_BLOCK_SRC     "layout(std140) uniform GLTFrameBlock { highp mat4 pMatrix; highp vec3 vLightPos; } frame;"
+#define GLT_OBJECT_BLOCK_SRC    "layout(std140) uniform GLTObjectBlock { highp mat4 mvMatrix; highp mat4 mvpMatrix; highp vec4 vColor; } object;"
+
+///////////////////////////////////////////////////////////////////////////////
+// Identity Shader (GLT_SHADER_IDENTITY)
+// This shader does no transformations at all, and uses the current
+// glColor value for fragments.
+// It will shade between verticies.
+static const char *szIdentityShaderVP =
+#ifndef OPENGL_ES
+                                        "#version 400\r\n"
+#else
+                                        "#version 300 es\r\n"
+#endif
+                                        "in vec4 vVertex;"
+                                        "void main(void) "
+                                        "{ gl_Position = vVertex; "
+                                        "}";
+
+static const char *szIdentityShaderFP =
+#ifndef OPENGL_ES
+                                        "#version 400\r\n"
+#else
+                                        "#version 300 es\r\n"
+#endif
+                                        "precision mediump float;"
+                                        "out vec4 vFragmentColor;"
+                                        GLT_OBJECT_BLOCK_SRC
+                                        "void main(void) "
+                                        "{ vFragmentColor = object.vColor;"
+                                        "}";
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Flat Shader (GLT_SHADER_FLAT)
+// This shader applies the given model view matrix to the verticies,
+// and uses a uniform color value.
+static const char *szFlatShaderVP =
+#ifndef OPENGL_ES
+                                    "#version 400\r\n"
+#else
+                                    "#version 300 es\r\n"
+
+#endif
+                                    "precision mediump float;"
+                                    GLT_OBJECT_BLOCK_SRC
+                                    "in vec4 vVertex;"
+                                    "void main(void) "
+                                    "{ gl_Position = object.mvpMatrix * vVertex; "
+                                    "}";
+
+static const char *szFlatShaderFP =
+#ifndef OPENGL_ES
+                                            "#version 400\r\n"
+#else
+                                            "#version 300 es\r\n"
+
+#endif
+                                    "precision mediump float;"
+                                    "out vec4 vFragmentColor;"
+                                    GLT_OBJECT_BLOCK_SRC
+                                    "void main(void) "
+                                    "{ vFragmentColor = object.vColor; "
+                                    "}";
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GLT_SHADER_SHADED
+// Point light, diffuse lighting only
+static const char *szShadedVP =
+#ifndef OPENGL_ES
+                                    "#version 400\r\n"
+#else
+                                    "#version 300 es\r\n"
+#endif
+                                    GLT_OBJECT_BLOCK_SRC
+                                    "in vec4 vColor;"
+                                    "in vec4 vVertex;"
+                                    "out vec4 vFragColor;"
+                                    "void main(void) {"
+                                    "vFragColor = vColor; "
+                                    " gl_Position = object.mvpMatrix * vVertex; "
+                                    "}";
+
+static const char *szShadedFP =
+        #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+        #else
+                                            "#version 300 es\r\n"
+
+        #endif
+                                    "precision mediump float;"
+                                    "out vec4 vFragmentColor;"
+                                    "in vec4 vFragColor; "
+                                    "void main(void) { "
+                                    " vFragmentColor = vFragColor; "
+#ifndef OPENGL_ES
+                                        " if(vFragmentColor.a == 0.0) discard;"
+#endif
+                                    "}";
+
+// GLT_SHADER_DEFAULT_LIGHT
+// Simple diffuse, directional, and vertex based light
+static const char *szDefaultLightVP =
+#ifndef OPENGL_ES
+                                    "#version 400\r\n"
+#else
+                                     "#version 300 es\r\n"
+
+#endif
+                                      GLT_FRAME_BLOCK_SRC
+                                      GLT_OBJECT_BLOCK_SRC
+                                      "out vec4 vFragColor;"
+                                      "in vec4 vVertex;"
+                                      "in vec3 vNormal;"
+                                      "void main(void) { "
+                                      " mat3 mNormalMatrix;"
+                                      " mNormalMatrix[0] = normalize(object.mvMatrix[0].xyz);"
+                                      " mNormalMatrix[1] = normalize(object.mvMatrix[1].xyz);"
+                                      " mNormalMatrix[2] = normalize(object.mvMatrix[2].xyz);"
+                                      " vec3 vNorm = normalize(mNormalMatrix * normalize(vNormal));"
+                                      " vec3 vLightDir = vec3(0.0, 0.0, 1.0); "
+                                      " float fDot = max(0.0, dot(vNorm, vLightDir)); "
+                                      " vFragColor.rgb = object.vColor.rgb * fDot;"
+                                      " vFragColor.a = object.vColor.a;"
+                                      " mat4 mvpMatrix;"
+                                      " mvpMatrix = frame.pMatrix * object.mvMatrix;"
+                                      " gl_Position = mvpMatrix * vVertex; "
+                                      "}";
+
+
+static const char *szDefaultLightFP =
+ #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+ #else
+                                        "#version 300 es\r\n"
+
+ #endif
+                                        "precision mediump float;"
+                                        "out vec4 vFragmentColor;"
+                                        "in vec4 vFragColor; "
+                                        "void main(void) { "
+                                        " vFragmentColor = vFragColor; "
+                                        "}";
+
+//GLT_SHADER_POINT_LIGHT_DIFF
+// Point light, diffuse lighting only
+static const char *szPointLightDiffVP =
+#ifndef OPENGL_ES
+                                          "#version 400\r\n"
+#else
+        "#version 300 es\r\n"
+#endif
+                                          GLT_FRAME_BLOCK_SRC
+                                          GLT_OBJECT_BLOCK_SRC
+                                          "in vec4 vVertex;"
+                                          "in vec3 vNormal;"
+                                          "out vec4 vFragColor;"
+                                          "void main(void) { "
+                                          " mat3 mNormalMatrix;"
+                                          " mNormalMatrix[0] = normalize(object.mvMatrix[0].xyz);"
+                                          " mNormalMatrix[1] = normalize(object.mvMatrix[1].xyz);"
+                                          " mNormalMatrix[2] = normalize(object.mvMatrix[2].xyz);"
+                                          " vec3 vNorm = normalize(mNormalMatrix * vNormal);"
+                                          " vec4 ecPosition;"
+                                          " vec3 ecPosition3;"
+                                          " ecPosition = object.mvMatrix * vVertex;"
+                                          " ecPosition3 = ecPosition.xyz /ecPosition.w;"
+                                          " vec3 vLightDir = normalize(frame.vLightPos - ecPosition3);"
+                                          " float fDot = max(0.0, dot(vNorm, vLightDir)); "
+                                          " vFragColor.rgb = object.vColor.rgb * fDot;"
+                                          " vFragColor.a = object.vColor.a;"
+                                          " mat4 mvpMatrix;"
+                                          " mvpMatrix = frame.pMatrix * object.mvMatrix;"
+                                          " gl_Position = mvpMatrix * vVertex; "
+                                          "}";
+
+
+static const char *szPointLightDiffFP =
+        #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+        #else
+                                            "#version 300 es\r\n"
+
+        #endif
+                                        "precision mediump float;"
+                                        "out vec4 vFragmentColor;"
+                                        "in vec4 vFragColor; "
+                                        "void main(void) { "
+                                        " vFragmentColor = vFragColor; "
+                                        "}";
+
+//GLT_SHADER_TEXTURE_REPLACE
+// Just put the texture on the polygons
+static const char *szTextureReplaceVP =
+#ifndef OPENGL_ES
+                                        "#version 400\r\n"
+#else
+                                        "#version 300 es\r\n"
+#endif
+                                        GLT_OBJECT_BLOCK_SRC
+                                        "in vec4 vVertex;"
+                                        "in vec2 vTexCoord0;"
+                                        "out vec2 vTex;"
+                                        "void main(void) "
+                                        "{ vTex = vTexCoord0;"
+                                        " gl_Position = object.mvpMatrix * vVertex; "
+                                        "}";
+
+static const char *szTextureReplaceFP =
+        #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+        #else
+                                            "#version 300 es\r\n"
+
+        #endif
+                                        "precision mediump float;"
+                                        "out vec4 vFragColor;"
+                                        "in vec2 vTex;"
+                                        "uniform sampler2D textureUnit0;"
+                                        "void main(void) "
+                                        "{ "
+                                        "vFragColor = texture(textureUnit0, vTex);"
+                                        "}";
+
+
+
+//GLT_SHADER_TEXTURE_MODULATE
+// Just put the texture on the polygons, but multiply by the color (as a unifomr)
+static const char *szTextureModulateVP =
+#ifndef OPENGL_ES
+                                        "#version 400\r\n"
+#else
+        "#version 300 es\r\n"
+#endif
+                                        GLT_OBJECT_BLOCK_SRC
+                                        "in vec4 vVertex;"
+                                        "in vec2 vTexCoord0;"
+                                        "out vec2 vTex;"
+                                        "void main(void) "
+                                        "{ vTex = vTexCoord0;"
+                                        " gl_Position = object.mvpMatrix * vVertex; "
+                                        "}";
+
+static const char *szTextureModulateFP =
+        #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+        #else
+                                            "#version 300 es\r\n"
+        #endif
+                                        "precision mediump float;"
+                                        "out vec4 vFragmentColor;"
+                                        "in vec2 vTex;"
+                                        "uniform sampler2D textureUnit0;"
+                                        GLT_OBJECT_BLOCK_SRC
+                                        "void main(void) "
+                                        "{ vFragmentColor = object.vColor * texture(textureUnit0, vTex); "
+                                        "}";
+
+
+
+
+//GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF
+// Point light (Diffuse only), with texture (modulated)
+static const char *szTexturePointLightDiffVP =
+#ifndef OPENGL_ES
+                                                 "#version 400\r\n"
+#else
+        "#version 300 es\r\n"
+#endif
+                                                  GLT_FRAME_BLOCK_SRC
+                                                  GLT_OBJECT_BLOCK_SRC
+                                                  "in vec4 vVertex;"
+                                                  "in vec3 vNormal;"
+                                                  "out vec4 vFragColor;"
+                                                  "in vec2 vTexCoord0;"
+                                                  "out vec2 vTex;"
+                                                  "void main(void) { "
+                                                  " mat3 mNormalMatrix;"
+                                                  " mNormalMatrix[0] = normalize(object.mvMatrix[0].xyz);"
+                                                  " mNormalMatrix[1] = normalize(object.mvMatrix[1].xyz);"
+                                                  " mNormalMatrix[2] = normalize(object.mvMatrix[2].xyz);"
+                                                  " vec3 vNorm = normalize(mNormalMatrix * vNormal);"
+                                                  " vec4 ecPosition;"
+                                                  " vec3 ecPosition3;"
+                                                  " ecPosition = object.mvMatrix * vVertex;"
+                                                  " ecPosition3 = ecPosition.xyz /ecPosition.w;"
+                                                  " vec3 vLightDir = normalize(frame.vLightPos - ecPosition3);"
+                                                  " float fDot = max(0.0, dot(vNorm, vLightDir)); "
+                                                  " vFragColor.rgb = (object.vColor.rgb * fDot);"
+                                                  " vFragColor.a = object.vColor.a;"
+                                                  " vTex = vTexCoord0;"
+                                                  " mat4 mvpMatrix;"
+                                                  " mvpMatrix = frame.pMatrix * object.mvMatrix;"
+                                                  " gl_Position = mvpMatrix * vVertex; "
+                                                  "}";
+
+
+static const char *szTexturePointLightDiffFP =
+        #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+        #else
+                                            "#version 300 es\r\n"
+
+        #endif
+                                                "precision mediump float;"
+                                                "out vec4 vFragmentColor;"
+                                                "in vec4 vFragColor;"
+                                                "in vec2 vTex;"
+                                                "uniform sampler2D textureUnit0;"
+                                                "void main(void) { "
+                                                " vFragmentColor = vFragColor * texture(textureUnit0, vTex);"
+                                                "}";
+
+
+
+
+
+// GLT_SHADER_POINT_SPRITES
+// Draws point sprites of a given size and color. Custom texture coordinates are required, as they are generally a lookup.
+static const char *szPointSpriteVP =
+#ifndef OPENGL_ES
+                                        "#version 400\r\n"
+#else
+        "#version 300 es\r\n"
+#endif
+                                        GLT_OBJECT_BLOCK_SRC
+                                        "in vec4 vVertex;"   // XYZ, and size
+                                        "in vec4 vTexCoord0;"
+                                        "in vec4 vColor;"
+                                        "out vec4 vTex;"
+                                        "out vec4 vPointColor;"
+                                        "void main(void) "
+                                        "{ vTex = vTexCoord0;"  // Pass through
+                                        "  vPointColor = vColor;"
+                                        "  gl_PointSize = vVertex.w;"
+                                        " gl_Position = object.mvpMatrix * vec4(vVertex.xyz, 1.0); "
+                                        "}";
+
+static const char *szPointSpriteFP =
+        #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+        #else
+                                            "#version 300 es\r\n"
+
+        #endif
+                                        "precision mediump float;"
+                                        "out vec4 vFragmentColor;"
+                                        "in vec4 vTex;"
+                                        "in vec4 vPointColor;"
+                                        "uniform sampler2D textureUnit0;"
+
+                                        "void main(void) "
+                                        " { vec2 vTexCoord;"
+                                        "   float w = gl_PointCoord.s * vTex.z;"    // Width scaled to texture cell width
+                                        "   float h = gl_PointCoord.t * vTex.w;"    // Height scaled to texture cell height
+                                        "   vTexCoord.x = vTex.x + w; "
+                                        "   vTexCoord.y = vTex.y + h; "
+                                        "   vFragmentColor = vPointColor * texture(textureUnit0, vTexCoord); "
+                                        "}";
+
+
+
+// GLT_SHADER_POINT_SPRITES_PLAIN
+// Draws point sprites of a given size and color. No texture.
+static const char *szPointSpritePlainVP =
+#ifndef OPENGL_ES
+                                        "#version 400\r\n"
+#else
+                                        "#version 300 es\r\n"
+#endif
+                                        GLT_OBJECT_BLOCK_SRC
+                                        "in vec4 vVertex;"   // XYZ, and size
+                                        "in vec4 vColor;"
+                                        "out vec4 vPointColor;"
+                                        "void main(void) "
+                                        "{ "
+                                        "  vPointColor = vec4(vColor.rgb, 1.0);"
+                                        "  gl_PointSize = vColor.w;"
+                                        " gl_Position = object.mvpMatrix * vec4(vVertex.xyz, 1.0); "
+                                        "}";
+
+static const char *szPointSpritePlainFP =
+        #ifndef OPENGL_ES
+                                            "#version 400\r\n"
+        #else
+                                            "#version 300 es\r\n"
+
+        #endif
+                                        "precision mediump float;"
+                                        "out vec4 vFragmentColor;"
+                                        "in vec4 vPointColor;"
+
+                                        "void main(void) "
+                                        " { "
+                                        " if(length(gl_PointCoord.st - vec2(0.5)) > 0.5)"
+                                        "     discard;"
+                                        "vFragmentColor = vPointColor; "
+                                        "}";
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Uber shader (UseShaderVariant)
+// One source for the common cases. Each GLT_SHADER_FEATURE bit turns into a
+// #define in front of it, so every variant only has the code it needs.
+// Color is the uniform color, times the vertex color, times the diffuse
+// light, times the texture, for whichever of those are turned on. If both
+// lights are asked for, the point light wins. Instanced variants apply the
+// instance transform before the model view, and multiply in the instance
+// color too. The instanced stock shaders are variants as well.
+#ifndef OPENGL_ES
+#define GLT_UBER_VERSION_SRC    "#version 400\r\n"
+#else
+#define GLT_UBER_VERSION_SRC    "#version 300 es\r\n"
+#endif
+
+static const char *szUberShaderVP =
+                                    GLT_FRAME_BLOCK_SRC
+                                    GLT_OBJECT_BLOCK_SRC
+                                    "in vec4 vVertex;"
+                                    "out vec4 vFragColor;\n"
+                                    "#ifdef GLT_VERTEX_COLOR\n"
+                                    "in vec4 vColor;\n"
+                                    "#endif\n"
+                                    "#if defined(GLT_DEFAULT_LIGHT) || defined(GLT_POINT_LIGHT)\n"
+                                    "in vec3 vNormal;\n"
+                                    "#endif\n"
+                                    "#ifdef GLT_TEXTURE\n"
+                                    "in vec2 vTexCoord0;"
+                                    "out vec2 vTex;\n"
+                                    "#endif\n"
+                                    "#ifdef GLT_INSTANCED\n"
+                                    "in mat4 vInstanceMatrix;"
+                                    "in vec4 vInstanceColor;\n"
+                                    "#endif\n"
+                                    "void main(void) {\n"
+                                    "#ifdef GLT_INSTANCED\n"
+                                    " vec4 vPosition = vInstanceMatrix * vVertex;"
+                                    " mat4 mvMatrix = object.mvMatrix * vInstanceMatrix;\n"
+                                    "#else\n"
+                                    " vec4 vPosition = vVertex;"
+                                    " mat4 mvMatrix = object.mvMatrix;\n"
+                                    "#endif\n"
+                                    " vec4 ecPosition = object.mvMatrix * vPosition;"
+                                    " vFragColor = object.vColor;\n"
+                                    "#ifdef GLT_INSTANCED\n"
+                                    " vFragColor *= vInstanceColor;\n"
+                                    "#endif\n"
+                                    "#ifdef GLT_VERTEX_COLOR\n"
+                                    " vFragColor *= vColor;\n"
+                                    "#endif\n"
+                                    "#if defined(GLT_DEFAULT_LIGHT) || defined(GLT_POINT_LIGHT)\n"
+                                    " mat3 mNormalMatrix;"
+                                    " mNormalMatrix[0] = normalize(mvMatrix[0].xyz);"
+                                    " mNormalMatrix[1] = normalize(mvMatrix[1].xyz);"
+                                    " mNormalMatrix[2] = normalize(mvMatrix[2].xyz);"
+                                    " vec3 vNorm = normalize(mNormalMatrix * normalize(vNormal));\n"
+                                    "#ifdef GLT_POINT_LIGHT\n"
+                                    " vec3 vLightDir = normalize(frame.vLightPos - ecPosition.xyz / ecPosition.w);\n"
+                                    "#else\n"
+                                    " vec3 vLightDir = vec3(0.0, 0.0, 1.0);\n"
+                                    "#endif\n"
+                                    " vFragColor.rgb *= max(0.0, dot(vNorm, vLightDir));\n"
+                                    "#endif\n"
+                                    "#ifdef GLT_TEXTURE\n"
+                                    " vTex = vTexCoord0;\n"
+                                    "#endif\n"
+                                    "#ifdef GLT_MVP_MATRIX\n"
+                                    " gl_Position = object.mvpMatrix * vPosition;\n"
+                                    "#else\n"
+                                    " gl_Position = frame.pMatrix * ecPosition;\n"
+                                    "#endif\n"
+                                    "}";
+
+static const char *szUberShaderFP =
+                                    "precision mediump float;"
+                                    "out vec4 vFragmentColor;"
+                                    "in vec4 vFragColor;\n"
+                                    "#ifdef GLT_TEXTURE\n"
+                                    "in vec2 vTex;"
+                                    "uniform sampler2D textureUnit0;\n"
+                                    "#endif\n"
+                                    "void main(void) { "
+                                    " vFragmentColor = vFragColor;\n"
+                                    "#ifdef GLT_TEXTURE\n"
+                                    " vFragmentColor *= texture(textureUnit0, vTex);\n"
+                                    "#endif\n"
+                                    "}";
+
+// One for each GLT_SHADER_FEATURE bit, in order
+static const char *szFeatureDefines[GLT_FEATURE_BITS] = { "#define GLT_VERTEX_COLOR\n", "#define GLT_TEXTURE\n",
+                                                          "#define GLT_DEFAULT_LIGHT\n", "#define GLT_POINT_LIGHT\n",
+                                                          "#define GLT_INSTANCED\n" };
+
+// Not a GLT_SHADER_FEATURE. Stock shaders that are only given the model view
+// projection matrix transform with that instead.
+#define GLT_STOCK_MVP_MATRIX	(1 << GLT_FEATURE_BITS)
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Source of an uber shader variant. The strings hold the text the source
+// points to. Binding attributes a variant doesn't use is harmless, so they
+// all get the same ones.
+static GLTSTOCKSHADERSOURCE UberShaderSource(GLuint nFeatures, std::string &strVertex, std::string &strFragment)
+    {
+    std::string strDefines(GLT_UBER_VERSION_SRC);
+    for(int i = 0; i < GLT_FEATURE_BITS; i++)
+        if(nFeatures & (1 << i))
+            strDefines += szFeatureDefines[i];
+
+    if(nFeatures & GLT_STOCK_MVP_MATRIX)
+        strDefines += "#define GLT_MVP_MATRIX\n";
+
+    strVertex = strDefines + szUberShaderVP;
+    strFragment = strDefines + szUberShaderFP;
+
+    GLTSTOCKSHADERSOURCE source = { strVertex.c_str(), strFragment.c_str(), 6,
+                                    { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_COLOR, GLT_ATTRIBUTE_NORMAL, GLT_ATTRIBUTE_TEXTURE0,
+                                      GLT_ATTRIBUTE_INSTANCE_MATRIX, GLT_ATTRIBUTE_INSTANCE_COLOR },
+                                    { "vVertex", "vColor", "vNormal", "vTexCoord0", "vInstanceMatrix", "vInstanceColor" } };
+    return source;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Features of the stock shaders that are uber shader variants, the ones with
+// no source of their own in stockShaderSource
+static GLuint StockShaderFeatures(int nShaderID)
+    {
+    switch(nShaderID) {
+        case GLT_SHADER_FLAT_INSTANCED:
+            return GLT_FEATURE_INSTANCED | GLT_STOCK_MVP_MATRIX;
+        case GLT_SHADER_DEFAULT_LIGHT_INSTANCED:
+            return GLT_FEATURE_INSTANCED | GLT_FEATURE_DEFAULT_LIGHT;
+        case GLT_SHADER_POINT_LIGHT_DIFF_INSTANCED:
+            return GLT_FEATURE_INSTANCED | GLT_FEATURE_POINT_LIGHT;
+        default:
+            return 0;
+        }
+    }
+
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Names of the stock uniforms, in GLT_STOCK_UNIFORM order
+static const char *szStockUniformNames[GLT_UNIFORM_LAST] = { "mvpMatrix", "mvMatrix", "pMatrix", "vColor",
+                                                             "vLightPos", "textureUnit0" };
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Source and attribute bindings of each stock shader, in GLT_STOCK_SHADER order
+static const GLTSTOCKSHADERSOURCE stockShaderSource[GLT_SHADER_LAST] = {
+    { szIdentityShaderVP, szIdentityShaderFP, 1, { GLT_ATTRIBUTE_VERTEX }, { "vVertex" } },
+    { szFlatShaderVP, szFlatShaderFP, 1, { GLT_ATTRIBUTE_VERTEX }, { "vVertex" } },
+    { szShadedVP, szShadedFP, 2, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_COLOR }, { "vVertex", "vColor" } },
+    { szDefaultLightVP, szDefaultLightFP, 2, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_NORMAL }, { "vVertex", "vNormal" } },
+    { szPointLightDiffVP, szPointLightDiffFP, 2, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_NORMAL }, { "vVertex", "vNormal" } },
+    { szTextureReplaceVP, szTextureReplaceFP, 2, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_TEXTURE0 }, { "vVertex", "vTexCoord0" } },
+    { szTextureModulateVP, szTextureModulateFP, 2, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_TEXTURE0 }, { "vVertex", "vTexCoord0" } },
+    { szTexturePointLightDiffVP, szTexturePointLightDiffFP, 3, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_NORMAL, GLT_ATTRIBUTE_TEXTURE0 },
+                                                                { "vVertex", "vNormal", "vTexCoord0" } },
+    { szPointSpriteVP, szPointSpriteFP, 3, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_COLOR, GLT_ATTRIBUTE_TEXTURE0 },
+                                                                { "vVertex", "vColor", "vTexCoord0" } },
+    { szPointSpritePlainVP, szPointSpritePlainFP, 2, { GLT_ATTRIBUTE_VERTEX, GLT_ATTRIBUTE_COLOR }, { "vVertex", "vColor" } },
+    { NULL, NULL, 0, { 0 }, { NULL } },		// The instanced ones are uber shader variants,
+    { NULL, NULL, 0, { 0 }, { NULL } },		// see StockShaderFeatures
+    { NULL, NULL, 0, { 0 }, { NULL } }
+    };
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor, just zero out everything
+GLShaderManager::GLShaderManager(void)
+    {
+    // Set stock shader handles to 0... uninitialized
+    for(unsigned int i = 0; i < GLT_SHADER_LAST; i++)
+        {
+        uiStockShaders[i] = 0;
+        bStockFailed[i] = false;
+        for(unsigned int j = 0; j < GLT_UNIFORM_LAST; j++)
+            iStockUniforms[i][j] = -1;
+        }
+
+    uiUniformRing = 0;
+    nRingOffset = 0;
+    nFrameOffset = 0;
+    nRingAlignment = 256;
+    memset(&frameBlock, 0, sizeof(GLTFRAMEBLOCK));
+    bFrameDirty = true;
+    bParallelCompile = false;
+
+    for(unsigned int i = 0; i < GLT_FEATURE_COMBINATIONS; i++) {
+        uiVariants[i] = 0;
+        iVariantTextureUnit[i] = -1;
+        }
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+GLShaderManager::~GLShaderManager(void)
+    {
+    }
+
+
+void GLShaderManager::freeGL(void)
+    {
+    // In lazy mode any of them may not have been built
+    for(int i = 0; i < GLT_SHADER_LAST; i++) {
+        if(uiStockShaders[i] != 0) {
+            GLStateCache::ForgetProgram(uiStockShaders[i]);
+            glDeleteProgram(uiStockShaders[i]);
+            uiStockShaders[i] = 0;
+            }
+        bStockFailed[i] = false;
+        }
+
+    for(int i = 0; i < GLT_FEATURE_COMBINATIONS; i++)
+        if(uiVariants[i] != 0) {
+            GLStateCache::ForgetProgram(uiVariants[i]);
+            glDeleteProgram(uiVariants[i]);
+            uiVariants[i] = 0;
+            }
+
+    // And everything that was loaded and never released
+    for(SHADERTABLE::iterator it = shaderTable.begin(); it != shaderTable.end(); ++it) {
+        GLStateCache::ForgetProgram(it->second.uiShaderID);
+        glDeleteProgram(it->second.uiShaderID);
+        }
+    shaderTable.clear();
+    shaderKeys.clear();
+    shaderNames.clear();
+
+    if(uiUniformRing != 0) {
+        GLStateCache::ForgetBuffers(1, &uiUniformRing);
+        glDeleteBuffers(1, &uiUniformRing);
+        uiUniformRing = 0;
+        }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Initialize and load the stock shaders
+bool GLShaderManager::InitializeStockShaders(void)
+    {
+    return InitializeStockShaders(false);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Initialize the stock shaders. In lazy mode only the ones in the warm up
+// list are built now, everything else waits until UseStockShader asks for it.
+bool GLShaderManager::InitializeStockShaders(bool bLazy, const int *pWarmUp, int nWarmUp)
+    {
+#ifdef QT_IS_AVAILABLE
+    initializeOpenGLFunctions();
+#endif
+
+    // With GL_KHR_parallel_shader_compile (or the ARB one) we can ask
+    // whether a program is done without waiting for it. The batched build
+    // below is only there for drivers that have it and more than one
+    // compiler thread. Anywhere else it does the same work as building the
+    // shaders one at a time, just in a different order, and is no faster.
+    bParallelCompile = false;
+    GLint nExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &nExtensions);
+    for(GLint i = 0; i < nExtensions; i++) {
+        const char *szExtension = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if(szExtension != NULL && (strcmp(szExtension, "GL_KHR_parallel_shader_compile") == 0 ||
+                                    strcmp(szExtension, "GL_ARB_parallel_shader_compile") == 0))
+            bParallelCompile = true;
+        }
+
+    // The ring buffer the blocks are written to. This comes first, the
+    // shaders that do build have to work even if some of the others don't.
+    if(uiUniformRing == 0) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &nRingAlignment);
+        if(nRingAlignment < 1)
+            nRingAlignment = 256;
+
+        glGenBuffers(1, &uiUniformRing);
+        GLStateCache::GetStateCache()->BindBuffer(GL_UNIFORM_BUFFER, uiUniformRing);
+        glBufferData(GL_UNIFORM_BUFFER, GLT_UNIFORM_RING_SIZE, NULL, GL_STREAM_DRAW);
+        nRingOffset = 0;
+        bFrameDirty = true;
+        }
+
+    // Which ones to build now
+    bool bBuild[GLT_SHADER_LAST];
+    for(int shader = GLT_SHADER_IDENTITY; shader < GLT_SHADER_LAST; shader++)
+        bBuild[shader] = !bLazy;
+
+    for(int i = 0; i < nWarmUp && pWarmUp != NULL; i++)
+        if(pWarmUp[i] >= 0 && pWarmUp[i] < GLT_SHADER_LAST)
+            bBuild[pWarmUp[i]] = true;
+
+    // Hand all of them to the driver before asking how any of them went. A
+    // status query waits for that compile to finish, so asking straight
+    // away would build them one at a time even on a driver that could
+    // compile them side by side.
+    GLTSHADERBUILD builds[GLT_SHADER_LAST];
+    int nToCollect = 0;
+    for(int shader = GLT_SHADER_IDENTITY; shader < GLT_SHADER_LAST; shader++)
+        if(bBuild[shader] && uiStockShaders[shader] == 0) {
+            StartStockShader(shader, builds[shader]);
+            nToCollect++;
+            }
+        else
+            bBuild[shader] = false;
+
+    // Now collect them. Take whichever is ready first if we can tell,
+    // otherwise just go in order.
+    bool bFailed = false;
+    for(int nCollected = 0; nCollected < nToCollect; nCollected++) {
+        int nNext = -1;
+        for(int shader = GLT_SHADER_IDENTITY; shader < GLT_SHADER_LAST; shader++) {
+            if(!bBuild[shader])
+                continue;
+
+            if(nNext < 0)
+                nNext = shader;
+
+            if(ShaderBuildReady(builds[shader])) {
+                nNext = shader;
+                break;
+                }
+            }
+
+        uiStockShaders[nNext] = FinishShaderBuild(builds[nNext]);
+        bBuild[nNext] = false;
+
+        bStockFailed[nNext] = (uiStockShaders[nNext] == 0);
+        if(uiStockShaders[nNext] != 0)
+            SetupStockShader(nNext);
+        else
+            bFailed = true;
+        }
+
+    // if any shader failed to build, return false
+    return !bFailed;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Look up every uniform location now, so UseStockShader never has to ask
+// the driver by name. Uniforms a shader doesn't have come back as -1.
+void GLShaderManager::SetupStockShader(int nShaderID)
+    {
+    GLuint hProgram = uiStockShaders[nShaderID];
+
+    for(int uniform = 0; uniform < GLT_UNIFORM_LAST; uniform++)
+        iStockUniforms[nShaderID][uniform] = glGetUniformLocation(hProgram, szStockUniformNames[uniform]);
+
+    BindUniformBlocks(hProgram);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Hook the stock uniform blocks up to their binding points, if it has them
+void GLShaderManager::BindUniformBlocks(GLuint hProgram)
+    {
+    GLuint iBlock = glGetUniformBlockIndex(hProgram, "GLTFrameBlock");
+    if(iBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(hProgram, iBlock, GLT_UNIFORM_BLOCK_FRAME);
+
+    iBlock = glGetUniformBlockIndex(hProgram, "GLTObjectBlock");
+    if(iBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(hProgram, iBlock, GLT_UNIFORM_BLOCK_OBJECT);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Build a stock shader that was left out in lazy mode, the first time it's
+// used. If it doesn't build it's marked as failed, and UseStockShader just
+// returns -1 for it from then on, the log only gets printed once.
+GLuint GLShaderManager::BuildStockShader(int nShaderID)
+    {
+    GLTSHADERBUILD build;
+
+    StartStockShader(nShaderID, build);
+    uiStockShaders[nShaderID] = FinishShaderBuild(build);
+    bStockFailed[nShaderID] = (uiStockShaders[nShaderID] == 0);
+    if(uiStockShaders[nShaderID] != 0)
+        SetupStockShader(nShaderID);
+
+    return uiStockShaders[nShaderID];
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+void GLShaderManager::StartStockShader(int nShaderID, GLTSHADERBUILD &build)
+    {
+    if(stockShaderSource[nShaderID].szVertexSrc == NULL) {
+        std::string strVertex, strFragment;
+        StartShaderBuild(UberShaderSource(StockShaderFeatures(nShaderID), strVertex, strFragment), build);
+        return;
+        }
+
+    StartShaderBuild(stockShaderSource[nShaderID], build);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Compile and link a shader pair, without checking anything. If it's in the
+// program binary cache, that's all there is to it.
+void GLShaderManager::StartShaderBuild(const GLTSTOCKSHADERSOURCE &source, GLTSHADERBUILD &build)
+    {
+    GLTools *pTools = GLTools::GetGLTools();
+
+    build.hVertexShader = glCreateShader(GL_VERTEX_SHADER);
+    build.hFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    pTools->gltLoadShaderSrc(source.szVertexSrc, build.hVertexShader);
+    pTools->gltLoadShaderSrc(source.szFragmentSrc, build.hFragmentShader);
+
+    build.nCacheKey = pTools->gltProgramCacheKey(build.hVertexShader, build.hFragmentShader,
+                                                 source.nAttributes, source.iAttributes, source.szAttributes);
+    build.hProgram = pTools->gltLoadProgramBinary(build.nCacheKey);
+    if(build.hProgram != 0) {
+        glDeleteShader(build.hVertexShader);
+        glDeleteShader(build.hFragmentShader);
+        build.hVertexShader = 0;
+        build.hFragmentShader = 0;
+        return;
+        }
+
+    glCompileShader(build.hVertexShader);
+    glCompileShader(build.hFragmentShader);
+
+    // Linking doesn't need us to look at the compile status first, it
+    // just fails if either shader didn't compile.
+    build.hProgram = glCreateProgram();
+    glAttachShader(build.hProgram, build.hVertexShader);
+    glAttachShader(build.hProgram, build.hFragmentShader);
+
+    for(int i = 0; i < source.nAttributes; i++)
+        glBindAttribLocation(build.hProgram, source.iAttributes[i], source.szAttributes[i]);
+
+    if(build.nCacheKey != 0)
+        glProgramParameteri(build.hProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    glLinkProgram(build.hProgram);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// True if finishing this one won't have to wait. Without parallel compile
+// we can't know, so say yes.
+bool GLShaderManager::ShaderBuildReady(const GLTSHADERBUILD &build)
+    {
+    if(!bParallelCompile || build.hVertexShader == 0)
+        return true;
+
+    GLint testVal = GL_TRUE;
+    glGetProgramiv(build.hProgram, GL_COMPLETION_STATUS_KHR, &testVal);
+    return (testVal != GL_FALSE);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Check the link, report what went wrong if it didn't work, and put a good
+// one in the program binary cache
+GLuint GLShaderManager::FinishShaderBuild(GLTSHADERBUILD &build)
+    {
+    // Straight out of the cache, already checked
+    if(build.hVertexShader == 0)
+        return build.hProgram;
+
+    GLint testVal;
+    glGetProgramiv(build.hProgram, GL_LINK_STATUS, &testVal);
+    if(testVal == GL_FALSE)
+        {
+        char infoLog[1024];
+        GLuint hShaders[2] = { build.hVertexShader, build.hFragmentShader };
+        for(int i = 0; i < 2; i++) {
+            glGetShaderiv(hShaders[i], GL_COMPILE_STATUS, &testVal);
+            if(testVal == GL_FALSE) {
+                glGetShaderInfoLog(hShaders[i], 1024, NULL, infoLog);
+                fprintf(stderr, "A shader failed to compile with the following error:\n%s\n", infoLog);
+                }
+            }
+
+        glGetProgramInfoLog(build.hProgram, 1024, NULL, infoLog);
+        fprintf(stderr, "A shader failed to link with the following error:\n%s\n", infoLog);
+        glDeleteProgram(build.hProgram);
+        build.hProgram = 0;
+        }
+    else
+        GLTools::GetGLTools()->gltSaveProgramBinary(build.nCacheKey, build.hProgram);
+
+    // These are no longer needed
+    glDeleteShader(build.hVertexShader);
+    glDeleteShader(build.hFragmentShader);
+    build.hVertexShader = 0;
+    build.hFragmentShader = 0;
+
+    return build.hProgram;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Uber shader variant for a set of features, built the first time it's asked for
+GLuint GLShaderManager::GetShaderVariant(GLuint nFeatures)
+    {
+    if(nFeatures >= GLT_FEATURE_COMBINATIONS)
+        return 0;
+
+    if(uiVariants[nFeatures] != 0)
+        return uiVariants[nFeatures];
+
+    std::string strVertex, strFragment;
+    GLTSHADERBUILD build;
+    StartShaderBuild(UberShaderSource(nFeatures, strVertex, strFragment), build);
+    uiVariants[nFeatures] = FinishShaderBuild(build);
+    if(uiVariants[nFeatures] != 0) {
+        iVariantTextureUnit[nFeatures] = glGetUniformLocation(uiVariants[nFeatures], "textureUnit0");
+        BindUniformBlocks(uiVariants[nFeatures]);
+        }
+
+    return uiVariants[nFeatures];
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Use the uber shader variant for a set of features. Everything is passed
+// every time, what a variant doesn't need is just ignored.
+GLint GLShaderManager::UseShaderVariant(GLuint nFeatures, const M3DMatrix44f &mvMatrix, const M3DMatrix44f &pMatrix,
+                                        const M3DVector3f &vLightPos, const M3DVector4f &vColor, GLint nTextureUnit)
+    {
+    GLuint hProgram = GetShaderVariant(nFeatures);
+    if(hProgram == 0)
+        return -1;
+
+    GLStateCache::GetStateCache()->UseProgram(hProgram);
+
+    // The variants transform with the projection and the model view, there
+    // is no need for the model view projection.
+    GLTOBJECTBLOCK objectBlock = {};
+    memcpy(objectBlock.mvMatrix, mvMatrix, sizeof(M3DMatrix44f));
+    memcpy(objectBlock.vColor, vColor, sizeof(M3DVector4f));
+
+    SetProjection(pMatrix);
+    if(nFeatures & GLT_FEATURE_POINT_LIGHT)
+        SetLightPosition(vLightPos);
+
+    if(nFeatures & GLT_FEATURE_TEXTURE)
+        glUniform1i(iVariantTextureUnit[nFeatures], nTextureUnit);
+
+    UploadStockBlocks(objectBlock);
+    return hProgram;
+    }
+
+
+///////////////////////////////////////////////////////////////////////
+// Use a specific stock shader, and set the appropriate uniforms. The
+// values go into the uniform blocks, the frame block is only uploaded
+// again if the projection or light position changed.
+GLint GLShaderManager::UseStockShader(int nShaderID, ...)
+    {
+    // Check for out of bounds
+    if(nShaderID < 0 || nShaderID >= GLT_SHADER_LAST)
+        return -1;
+
+    // Bind to the correct shader, in lazy mode it may have to be built first
+    GLuint hProgram = GetStockShader(nShaderID);
+    if(hProgram == 0)
+        return -1;
+
+    GLStateCache::GetStateCache()->UseProgram(hProgram);
+
+    // List of uniforms
+    va_list uniformList;
+    va_start(uniformList, nShaderID);
+
+    // Set up the uniforms. The texture unit location was cached by InitializeStockShaders
+    GLTOBJECTBLOCK objectBlock = {};
+    GLint iTextureUnit;
+    int				iInteger;
+    M3DMatrix44f* mvpMatrix;
+    M3DMatrix44f*  pMatrix;
+    M3DMatrix44f*  mvMatrix;
+    M3DVector4f*  vColor;
+    M3DVector3f*  vLightPos;
+
+
+    switch(nShaderID)
+        {
+        case GLT_SHADER_FLAT:			// Just the modelview projection matrix and the color
+        case GLT_SHADER_FLAT_INSTANCED:
+            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvpMatrix, *mvpMatrix, sizeof(M3DMatrix44f));
+
+            vColor = va_arg(uniformList, M3DVector4f*);
+            memcpy(objectBlock.vColor, *vColor, sizeof(M3DVector4f));
+            break;
+
+    case GLT_SHADER_TEXTURE_REPLACE:	// Just the texture place
+            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvpMatrix, *mvpMatrix, sizeof(M3DMatrix44f));
+
+            iTextureUnit = iStockUniforms[nShaderID][GLT_UNIFORM_TEXTURE_UNIT0];
+            iInteger = va_arg(uniformList, int);
+            glUniform1i(iTextureUnit, iInteger);
+            break;
+
+        case GLT_SHADER_TEXTURE_MODULATE: // Multiply the texture by the geometry color
+            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvpMatrix, *mvpMatrix, sizeof(M3DMatrix44f));
+
+            vColor = va_arg(uniformList, M3DVector4f*);
+            memcpy(objectBlock.vColor, *vColor, sizeof(M3DVector4f));
+
+            iTextureUnit = iStockUniforms[nShaderID][GLT_UNIFORM_TEXTURE_UNIT0];
+            iInteger = va_arg(uniformList, int);
+            glUniform1i(iTextureUnit, iInteger);
+            break;
+
+        case GLT_SHADER_POINT_SPRITES:
+            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvpMatrix, *mvpMatrix, sizeof(M3DMatrix44f));
+
+            iTextureUnit = iStockUniforms[nShaderID][GLT_UNIFORM_TEXTURE_UNIT0];
+            iInteger = va_arg(uniformList, int);
+            glUniform1i(iTextureUnit, iInteger);
+            break;
+
+        case GLT_POINT_SPRITES_PLAIN:
+            mvpMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvpMatrix, *mvpMatrix, sizeof(M3DMatrix44f));
+            break;
+
+        case GLT_SHADER_DEFAULT_LIGHT:
+        case GLT_SHADER_DEFAULT_LIGHT_INSTANCED:
+            mvMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvMatrix, *mvMatrix, sizeof(M3DMatrix44f));
+
+            pMatrix = va_arg(uniformList, M3DMatrix44f*);
+            SetProjection(*pMatrix);
+
+            vColor = va_arg(uniformList, M3DVector4f*);
+            memcpy(objectBlock.vColor, *vColor, sizeof(M3DVector4f));
+            break;
+
+        // The uniforms of the textured version can't be set by hand any more,
+        // they are in the blocks. It takes the same parameters as the point
+        // light shader, plus the texture unit.
+        case GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF:
+        case GLT_SHADER_POINT_LIGHT_DIFF:
+        case GLT_SHADER_POINT_LIGHT_DIFF_INSTANCED:
+            mvMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvMatrix, *mvMatrix, sizeof(M3DMatrix44f));
+
+            pMatrix = va_arg(uniformList, M3DMatrix44f*);
+            SetProjection(*pMatrix);
+
+            vLightPos = va_arg(uniformList, M3DVector3f*);
+            SetLightPosition(*vLightPos);
+
+            vColor = va_arg(uniformList, M3DVector4f*);
+            memcpy(objectBlock.vColor, *vColor, sizeof(M3DVector4f));
+
+            if(nShaderID == GLT_SHADER_TEXTURE_POINT_LIGHT_DIFF) {
+                iTextureUnit = iStockUniforms[nShaderID][GLT_UNIFORM_TEXTURE_UNIT0];
+                iInteger = va_arg(uniformList, int);
+                glUniform1i(iTextureUnit, iInteger);
+                }
+            break;
+
+        case GLT_SHADER_SHADED:		// Just the modelview projection matrix. Color is an attribute
+            pMatrix = va_arg(uniformList, M3DMatrix44f*);
+            memcpy(objectBlock.mvpMatrix, *pMatrix, sizeof(M3DMatrix44f));
+            break;
+
+        case GLT_SHADER_IDENTITY:	// Just the Color
+            vColor = va_arg(uniformList, M3DVector4f*);
+            memcpy(objectBlock.vColor, *vColor, sizeof(M3DVector4f));
+        default:
+            break;
+        }
+    va_end(uniformList);
+
+    UploadStockBlocks(objectBlock);
+
+    return uiStockShaders[nShaderID];
+    }
+
+
+///////////////////////////////////////////////////////////////////////
+// Round up to the uniform buffer offset alignment
+static inline GLintptr AlignRing(GLintptr nOffset, GLint nAlignment)
+    {
+    return ((nOffset + nAlignment - 1) / nAlignment) * nAlignment;
+    }
+
+
+///////////////////////////////////////////////////////////////////////
+// Write this draw's object block to the ring, and the frame block too
+// if it has changed, then point the two binding points at them. When
+// the ring is full it is orphaned, and the driver hands us fresh storage
+// while draws still in flight keep the old. The frame block was in the
+// old storage, so it has to be written again.
+void GLShaderManager::UploadStockBlocks(const GLTOBJECTBLOCK &objectBlock)
+    {
+    GLStateCache *pState = GLStateCache::GetStateCache();
+    pState->BindBuffer(GL_UNIFORM_BUFFER, uiUniformRing);
+
+    GLintptr nFrameSize = AlignRing(sizeof(GLTFRAMEBLOCK), nRingAlignment);
+    GLintptr nObjectSize = AlignRing(sizeof(GLTOBJECTBLOCK), nRingAlignment);
+    GLintptr nOffset = AlignRing(nRingOffset, nRingAlignment);
+
+    if(nOffset + nFrameSize + nObjectSize > GLT_UNIFORM_RING_SIZE) {
+        glBufferData(GL_UNIFORM_BUFFER, GLT_UNIFORM_RING_SIZE, NULL, GL_STREAM_DRAW);
+        nOffset = 0;
+        bFrameDirty = true;
+        }
+
+    if(bFrameDirty) {
+        glBufferSubData(GL_UNIFORM_BUFFER, nOffset, sizeof(GLTFRAMEBLOCK), &frameBlock);
+        nFrameOffset = nOffset;
+        nOffset += nFrameSize;
+        bFrameDirty = false;
+        }
+
+    glBufferSubData(GL_UNIFORM_BUFFER, nOffset, sizeof(GLTOBJECTBLOCK), &objectBlock);
+
+    // Someone else may have used these binding points, so always bind both
+    pState->BindBufferRange(GL_UNIFORM_BUFFER, GLT_UNIFORM_BLOCK_FRAME, uiUniformRing, nFrameOffset, sizeof(GLTFRAMEBLOCK));
+    pState->BindBufferRange(GL_UNIFORM_BUFFER, GLT_UNIFORM_BLOCK_OBJECT, uiUniformRing, nOffset, sizeof(GLTOBJECTBLOCK));
+
+    nRingOffset = nOffset + nObjectSize;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Shader lookup table. Pairs loaded from files are filed under both file
+// names.
+static std::string ShaderKey(const char *szVertexName, const char *szFragName)
+    {
+    std::string strKey(szVertexName);
+    strKey += '\n';
+    strKey += szFragName;
+    return strKey;
+    }
+
+// Pairs from source are filed under the name they were given. A file name
+// doesn't start with a 1, so "x" here never finds the pair loaded from the
+// files "x" and "x".
+static std::string NameKey(const char *szName)
+    {
+    std::string strKey(1, '\1');
+    strKey += szName;
+    return strKey;
+    }
+
+// The attribute bindings go on the end of the key, so the same shaders bound
+// two different ways are two different programs. Each one starts with a zero.
+static void AppendAttributes(std::string &strKey, int nAttributes, va_list *pAttributes)
+    {
+    for(int i = 0; i < nAttributes && pAttributes != NULL; i++) {
+        char szIndex[16];
+        snprintf(szIndex, sizeof(szIndex), "%d ", va_arg(*pAttributes, int));
+        strKey += '\0';
+        strKey += szIndex;
+        strKey += va_arg(*pAttributes, char*);
+        }
+    }
+
+// Source is filed under the source, and the attributes. A name can't start
+// with a zero, so unnamed source never collides with anything. Named source
+// puts its NameKey() in front of this.
+static std::string SourceKey(const char *szVertexSrc, const char *szFragSrc, int nAttributes, va_list *pAttributes)
+    {
+    std::string strKey(1, '\0');
+    strKey += szVertexSrc;
+    strKey += '\0';
+    strKey += szFragSrc;
+    AppendAttributes(strKey, nAttributes, pAttributes);
+    return strKey;
+    }
+
+// The name part of a key, what LookupShader finds it by. Everything from the
+// first zero on is source and attributes, so unnamed source has no name.
+static std::string KeyName(const std::string &strKey)
+    {
+    return strKey.substr(0, strKey.find('\0'));
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Already loaded? Then it's one more reference to the same program.
+GLuint GLShaderManager::FindShader(const std::string &strKey)
+    {
+    SHADERTABLE::iterator it = shaderTable.find(strKey);
+    if(it == shaderTable.end())
+        return 0;
+
+    it->second.nRefCount++;
+    return it->second.uiShaderID;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+void GLShaderManager::AddShader(const std::string &strKey, const char *szVertexName, const char *szFragName, GLuint hProgram)
+    {
+    SHADERLOOKUPENTRY shaderEntry;
+
+    strncpy(shaderEntry.szVertexShaderName, szVertexName, MAX_SHADER_NAME_LENGTH - 1);
+    strncpy(shaderEntry.szFragShaderName, szFragName, MAX_SHADER_NAME_LENGTH - 1);
+    shaderEntry.szVertexShaderName[MAX_SHADER_NAME_LENGTH - 1] = '\0';
+    shaderEntry.szFragShaderName[MAX_SHADER_NAME_LENGTH - 1] = '\0';
+    shaderEntry.uiShaderID = hProgram;
+    shaderEntry.nRefCount = 1;
+
+    shaderTable[strKey] = shaderEntry;
+    shaderKeys[hProgram] = strKey;
+
+    // The first program under a name is the one LookupShader finds
+    std::string strName = KeyName(strKey);
+    if(!strName.empty() && shaderNames.find(strName) == shaderNames.end())
+        shaderNames[strName] = hProgram;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Named source is one program per name. Asking for that name again with
+// different source or bindings is a mistake, and handing back the program
+// that's already there would be another one.
+bool GLShaderManager::ShaderNameTaken(const std::string &strKey, const char *szName)
+    {
+    if(shaderNames.find(KeyName(strKey)) == shaderNames.end())
+        return false;
+
+    fprintf(stderr, "The shader name %s is already used by a different program\n", szName);
+    return true;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Drop a reference, and the program with the last one
+void GLShaderManager::ReleaseShader(GLuint hProgram)
+    {
+    std::unordered_map<GLuint, std::string>::iterator itKey = shaderKeys.find(hProgram);
+    if(itKey == shaderKeys.end())
+        return;
+
+    SHADERTABLE::iterator it = shaderTable.find(itKey->second);
+    if(it != shaderTable.end()) {
+        if(--it->second.nRefCount > 0)
+            return;
+
+        shaderTable.erase(it);
+        }
+
+    // If the name was this one's, it goes to another program with the same
+    // file names (bound differently), if there is one
+    std::string strName = KeyName(itKey->second);
+    std::unordered_map<std::string, GLuint>::iterator itName = shaderNames.find(strName);
+    if(itName != shaderNames.end() && itName->second == hProgram) {
+        shaderNames.erase(itName);
+        for(it = shaderTable.begin(); it != shaderTable.end(); ++it)
+            if(KeyName(it->first) == strName) {
+                shaderNames[strName] = it->second.uiShaderID;
+                break;
+                }
+        }
+
+    shaderKeys.erase(itKey);
+    GLStateCache::ForgetProgram(hProgram);
+    glDeleteProgram(hProgram);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Find a loaded pair by name. For source, just pass the one name.
+GLuint GLShaderManager::LookupShader(const char *szVertexProg, const char *szFragProg)
+    {
+    if(szVertexProg == NULL)
+        return 0;
+
+    std::unordered_map<std::string, GLuint>::iterator it = shaderNames.find((szFragProg != NULL) ? ShaderKey(szVertexProg, szFragProg) : NameKey(szVertexProg));
+    if(it == shaderNames.end())
+        return 0;
+
+    return it->second;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Load a shader pair from file. The shader pair is added to the shader
+// lookup table and can be found again if necessary with LookupShader.
+GLuint GLShaderManager::LoadShaderPair(const char *szVertexProgFileName, const char *szFragProgFileName)
+    {
+    if(szVertexProgFileName == NULL || szFragProgFileName == NULL)
+        return 0;
+
+    std::string strKey = ShaderKey(szVertexProgFileName, szFragProgFileName);
+    GLuint hProgram = FindShader(strKey);
+    if(hProgram != 0)
+        return hProgram;
+
+    // Load shader and test for fail
+    hProgram = GLTools::GetGLTools()->gltLoadShaderPair(szVertexProgFileName, szFragProgFileName);
+    if(hProgram == 0)
+        return 0;
+
+    // Add to the table
+    AddShader(strKey, szVertexProgFileName, szFragProgFileName, hProgram);
+    return hProgram;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Load shaders from source text. If the szName is NULL, it's filed under the source
+// itself. Either way, make sure it's not already there, then add to list
+GLuint GLShaderManager::LoadShaderPairSrc(const char *szName, const char *szVertexSrc, const char *szFragSrc)
+    {
+    if(szVertexSrc == NULL || szFragSrc == NULL)
+        return 0;
+
+    std::string strKey = SourceKey(szVertexSrc, szFragSrc, 0, NULL);
+    if(szName != NULL)
+        strKey = NameKey(szName) + strKey;
+
+    GLuint hProgram = FindShader(strKey);
+    if(hProgram != 0)
+        return hProgram;
+
+    if(szName != NULL && ShaderNameTaken(strKey, szName))
+        return 0;
+
+    // Ok, make it and add to table
+    hProgram = GLTools::GetGLTools()->gltLoadShaderPairSrc(szVertexSrc, szFragSrc);
+    if(hProgram == 0)
+        return 0;	// Game over, won't compile
+
+    // Add it...
+    AddShader(strKey, (szName != NULL) ? szName : "", (szName != NULL) ? szName : "", hProgram);
+    return hProgram;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// Load the shader file, with the supplied named attributes
+GLuint GLShaderManager::LoadShaderPairWithAttributes(const char *szVertexProgFileName, const char *szFragmentProgFileName, ...)
+    {
+    SHADERLOOKUPENTRY shaderEntry;
+
+    if(szVertexProgFileName == NULL || szFragmentProgFileName == NULL)
+        return 0;
+
+    // Already loaded, with the same bindings?
+    std::string strKey = ShaderKey(szVertexProgFileName, szFragmentProgFileName);
+    va_list attributeList;
+    va_start(attributeList, szFragmentProgFileName);
+    int nAttributes = va_arg(attributeList, int);
+    AppendAttributes(strKey, nAttributes, &attributeList);
+    va_end(attributeList);
+
+    shaderEntry.uiShaderID = FindShader(strKey);
+    if(shaderEntry.uiShaderID != 0)
+        return shaderEntry.uiShaderID;
+
+    // Temporary Shader objects
+    GLuint hVertexShader;
+    GLuint hFragmentShader;
+    GLint testVal;
+
+    // Create shader objects
+    hVertexShader = glCreateShader(GL_VERTEX_SHADER);
+    hFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+
+    // Load them. If fail clean up and return null
+    if(GLTools::GetGLTools()->gltLoadShaderFile(szVertexProgFileName, hVertexShader) == false)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        return 0;
+        }
+
+    if(GLTools::GetGLTools()->gltLoadShaderFile(szFragmentProgFileName, hFragmentShader) == false)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        return 0;
+        }
+
+    // See if we've built this one before
+    va_start(attributeList, szFragmentProgFileName);
+    nAttributes = va_arg(attributeList, int);
+    GLuint64 nCacheKey = GLTools::GetGLTools()->gltProgramCacheKey(hVertexShader, hFragmentShader, nAttributes, &attributeList);
+    va_end(attributeList);
+
+    shaderEntry.uiShaderID = GLTools::GetGLTools()->gltLoadProgramBinary(nCacheKey);
+    if(shaderEntry.uiShaderID != 0)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        AddShader(strKey, szVertexProgFileName, szFragmentProgFileName, shaderEntry.uiShaderID);
+        return shaderEntry.uiShaderID;
+        }
+
+    // Compile them
+    glCompileShader(hVertexShader);
+    glCompileShader(hFragmentShader);
+
+    // Check for errors
+    glGetShaderiv(hVertexShader, GL_COMPILE_STATUS, &testVal);
+    if(testVal == GL_FALSE)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        return 0;
+        }
+
+    glGetShaderiv(hFragmentShader, GL_COMPILE_STATUS, &testVal);
+    if(testVal == GL_FALSE)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        return 0;
+        }
+
+    // Link them - assuming it works...
+    shaderEntry.uiShaderID = glCreateProgram();
+    glAttachShader(shaderEntry.uiShaderID, hVertexShader);
+    glAttachShader(shaderEntry.uiShaderID, hFragmentShader);
+
+
+    // List of attributes
+    va_start(attributeList, szFragmentProgFileName);
+
+    char *szNextArg;
+    int iArgCount = va_arg(attributeList, int);	// Number of attributes
+    for(int i = 0; i < iArgCount; i++)
+        {
+        int index = va_arg(attributeList, int);
+        szNextArg = va_arg(attributeList, char*);
+        glBindAttribLocation(shaderEntry.uiShaderID, index, szNextArg);
+        }
+
+    va_end(attributeList);
+
+    // Ask for a binary we can cache
+    if(nCacheKey != 0)
+        glProgramParameteri(shaderEntry.uiShaderID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    glLinkProgram(shaderEntry.uiShaderID);
+
+    // These are no longer needed
+    glDeleteShader(hVertexShader);
+    glDeleteShader(hFragmentShader);
+
+    // Make sure link worked too
+    glGetProgramiv(shaderEntry.uiShaderID, GL_LINK_STATUS, &testVal);
+    if(testVal == GL_FALSE)
+        {
+        glDeleteProgram(shaderEntry.uiShaderID);
+        return 0;
+        }
+
+
+    GLTools::GetGLTools()->gltSaveProgramBinary(nCacheKey, shaderEntry.uiShaderID);
+
+    // Add it...
+    AddShader(strKey, szVertexProgFileName, szFragmentProgFileName, shaderEntry.uiShaderID);
+    return shaderEntry.uiShaderID;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// Load the shader from source, with the supplied named attributes
+GLuint GLShaderManager::LoadShaderPairSrcWithAttributes(const char *szName, const char *szVertexProg, const char *szFragmentProg, ...)
+    {
+    SHADERLOOKUPENTRY shaderEntry;
+    va_list attributeList;
+
+    if(szVertexProg == NULL || szFragmentProg == NULL)
+        return 0;
+
+    // Already loaded?
+    va_start(attributeList, szFragmentProg);
+    int nAttributes = va_arg(attributeList, int);
+    std::string strKey = SourceKey(szVertexProg, szFragmentProg, nAttributes, &attributeList);
+    va_end(attributeList);
+    if(szName != NULL)
+        strKey = NameKey(szName) + strKey;
+
+    shaderEntry.uiShaderID = FindShader(strKey);
+    if(shaderEntry.uiShaderID != 0)
+        return shaderEntry.uiShaderID;
+
+    if(szName != NULL && ShaderNameTaken(strKey, szName))
+        return 0;
+
+    // Temporary Shader objects
+    GLuint hVertexShader;
+    GLuint hFragmentShader;
+    GLint testVal;
+
+    // Create shader objects
+    hVertexShader = glCreateShader(GL_VERTEX_SHADER);
+    hFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+
+    // Load them.
+    GLTools::GetGLTools()->gltLoadShaderSrc(szVertexProg, hVertexShader);
+    GLTools::GetGLTools()->gltLoadShaderSrc(szFragmentProg, hFragmentShader);
+
+    // See if we've built this one before
+    va_start(attributeList, szFragmentProg);
+    nAttributes = va_arg(attributeList, int);
+    GLuint64 nCacheKey = GLTools::GetGLTools()->gltProgramCacheKey(hVertexShader, hFragmentShader, nAttributes, &attributeList);
+    va_end(attributeList);
+
+    shaderEntry.uiShaderID = GLTools::GetGLTools()->gltLoadProgramBinary(nCacheKey);
+    if(shaderEntry.uiShaderID != 0)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        AddShader(strKey, (szName != NULL) ? szName : "", (szName != NULL) ? szName : "", shaderEntry.uiShaderID);
+        return shaderEntry.uiShaderID;
+        }
+
+    // Compile them
+    glCompileShader(hVertexShader);
+    glCompileShader(hFragmentShader);
+
+    // Check for errors
+    glGetShaderiv(hVertexShader, GL_COMPILE_STATUS, &testVal);
+    if(testVal == GL_FALSE)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        return 0;
+        }
+
+    glGetShaderiv(hFragmentShader, GL_COMPILE_STATUS, &testVal);
+    if(testVal == GL_FALSE)
+        {
+        glDeleteShader(hVertexShader);
+        glDeleteShader(hFragmentShader);
+        return 0;
+        }
+
+    // Link them - assuming it works...
+    shaderEntry.uiShaderID = glCreateProgram();
+    glAttachShader(shaderEntry.uiShaderID, hVertexShader);
+    glAttachShader(shaderEntry.uiShaderID, hFragmentShader);
+
+    // List of attributes
+    va_start(attributeList, szFragmentProg);
+
+    char *szNextArg;
+    int iArgCount = va_arg(attributeList, int);	// Number of attributes
+    for(int i = 0; i < iArgCount; i++)
+        {
+        int index = va_arg(attributeList, int);
+        szNextArg = va_arg(attributeList, char*);
+        glBindAttribLocation(shaderEntry.uiShaderID, index, szNextArg);
+        }
+    va_end(attributeList);
+
+
+    // Ask for a binary we can cache
+    if(nCacheKey != 0)
+        glProgramParameteri(shaderEntry.uiShaderID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    glLinkProgram(shaderEntry.uiShaderID);
+
+    // These are no longer needed
+    glDeleteShader(hVertexShader);
+    glDeleteShader(hFragmentShader);
+
+    // Make sure link worked too
+    glGetProgramiv(shaderEntry.uiShaderID, GL_LINK_STATUS, &testVal);
+    if(testVal == GL_FALSE)
+        {
+        glDeleteProgram(shaderEntry.uiShaderID);
+        return 0;
+        }
+
+    GLTools::GetGLTools()->gltSaveProgramBinary(nCacheKey, shaderEntry.uiShaderID);
+
+    // Add it...
+    AddShader(strKey, (szName != NULL) ? szName : "", (szName != NULL) ? szName : "", shaderEntry.uiShaderID);
+    return shaderEntry.uiShaderID;
+    }
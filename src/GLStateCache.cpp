@@ -0,0 +1,214 @@
+/* GLStateCache.cpp
+
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "GLTools.h"
+#include "GLStateCache.h"
+
+
+GLStateCache* GLStateCache::pMe = NULL;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Which slot a texture target lives in, -1 if we don't track it
+static int TextureTargetSlot(GLenum target)
+    {
+    switch(target)
+        {
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_CUBE_MAP:
+            return 1;
+        case GL_TEXTURE_2D_ARRAY:
+            return 2;
+        case GL_TEXTURE_3D:
+            return 3;
+        default:
+            return -1;
+        }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+void GLStateCache::Invalidate(void)
+    {
+    uiProgram = GLT_STATE_UNKNOWN;
+    uiVertexArray = GLT_STATE_UNKNOWN;
+    uiArrayBuffer = GLT_STATE_UNKNOWN;
+    uiElementBuffer = GLT_STATE_UNKNOWN;
+    uiUniformBuffer = GLT_STATE_UNKNOWN;
+    uiActiveTexture = GLT_STATE_UNKNOWN;
+    uiDrawFramebuffer = GLT_STATE_UNKNOWN;
+    uiReadFramebuffer = GLT_STATE_UNKNOWN;
+
+    for(int i = 0; i < GLT_STATE_TEXTURE_UNITS; i++)
+        for(int j = 0; j < GLT_STATE_TEXTURE_TARGETS; j++)
+            uiTextures[i][j] = GLT_STATE_UNKNOWN;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+void GLStateCache::ResetStats(void)
+    {
+    for(int i = 0; i < GLT_STATE_LAST; i++) {
+        stats.nIssued[i] = 0;
+        stats.nFiltered[i] = 0;
+        }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Texture bindings are per unit, so we need to know the active unit to
+// filter anything. If we don't, or the target isn't one we track, it just
+// goes through.
+void GLStateCache::BindTexture(GLenum target, GLuint texture)
+    {
+    int nSlot = TextureTargetSlot(target);
+    GLuint nUnit = uiActiveTexture - GL_TEXTURE0;
+
+    if(nSlot < 0 || uiActiveTexture == GLT_STATE_UNKNOWN || nUnit >= GLT_STATE_TEXTURE_UNITS) {
+        stats.nIssued[GLT_STATE_TEXTURE]++;
+        glBindTexture(target, texture);
+        return;
+        }
+
+    if(!Filter(GLT_STATE_TEXTURE, uiTextures[nUnit][nSlot], texture))
+        glBindTexture(target, texture);
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GL_FRAMEBUFFER sets both the draw and the read binding
+void GLStateCache::BindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+    switch(target)
+        {
+        case GL_DRAW_FRAMEBUFFER:
+            if(!Filter(GLT_STATE_FRAMEBUFFER, uiDrawFramebuffer, framebuffer))
+                glBindFramebuffer(target, framebuffer);
+            break;
+
+        case GL_READ_FRAMEBUFFER:
+            if(!Filter(GLT_STATE_FRAMEBUFFER, uiReadFramebuffer, framebuffer))
+                glBindFramebuffer(target, framebuffer);
+            break;
+
+        default:
+            if(bEnabled && uiDrawFramebuffer == framebuffer && uiReadFramebuffer == framebuffer) {
+                stats.nFiltered[GLT_STATE_FRAMEBUFFER]++;
+                break;
+                }
+
+            uiDrawFramebuffer = framebuffer;
+            uiReadFramebuffer = framebuffer;
+            stats.nIssued[GLT_STATE_FRAMEBUFFER]++;
+            glBindFramebuffer(target, framebuffer);
+            break;
+        }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// A deleted program stays in use until something else is, but its name
+// can't be trusted after that. Simplest to just not know.
+void GLStateCache::ForgetProgram(GLuint program)
+    {
+    if(pMe != NULL && pMe->uiProgram == program)
+        pMe->uiProgram = GLT_STATE_UNKNOWN;
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Deleting the bound VAO binds zero, which has its own element buffer
+void GLStateCache::ForgetVertexArrays(GLsizei n, const GLuint *pArrays)
+    {
+    if(pMe == NULL)
+        return;
+
+    for(GLsizei i = 0; i < n; i++)
+        if(pArrays[i] != 0 && pMe->uiVertexArray == pArrays[i]) {
+            pMe->uiVertexArray = 0;
+            pMe->uiElementBuffer = GLT_STATE_UNKNOWN;
+            }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+void GLStateCache::ForgetBuffers(GLsizei n, const GLuint *pBuffers)
+    {
+    if(pMe == NULL)
+        return;
+
+    for(GLsizei i = 0; i < n; i++) {
+        if(pBuffers[i] == 0)
+            continue;
+
+        if(pMe->uiArrayBuffer == pBuffers[i])
+            pMe->uiArrayBuffer = 0;
+
+        if(pMe->uiElementBuffer == pBuffers[i])
+            pMe->uiElementBuffer = 0;
+
+        if(pMe->uiUniformBuffer == pBuffers[i])
+            pMe->uiUniformBuffer = 0;
+        }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+void GLStateCache::ForgetTextures(GLsizei n, const GLuint *pTextures)
+    {
+    if(pMe == NULL)
+        return;
+
+    for(GLsizei i = 0; i < n; i++) {
+        if(pTextures[i] == 0)
+            continue;
+
+        for(int u = 0; u < GLT_STATE_TEXTURE_UNITS; u++)
+            for(int t = 0; t < GLT_STATE_TEXTURE_TARGETS; t++)
+                if(pMe->uiTextures[u][t] == pTextures[i])
+                    pMe->uiTextures[u][t] = 0;
+        }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////
+void GLStateCache::ForgetFramebuffers(GLsizei n, const GLuint *pFramebuffers)
+    {
+    if(pMe == NULL)
+        return;
+
+    for(GLsizei i = 0; i < n; i++) {
+        if(pFramebuffers[i] == 0)
+            continue;
+
+        if(pMe->uiDrawFramebuffer == pFramebuffers[i])
+            pMe->uiDrawFramebuffer = 0;
+
+        if(pMe->uiReadFramebuffer == pFramebuffers[i])
+            pMe->uiReadFramebuffer = 0;
+        }
+    }
@@ -1,506 +1,2399 @@
-/*
- *  GLTriangleBatch.cpp
- *
-
-Copyright (c) 2007-2023, Richard S. Wright Jr.
-All rights reserved.
-
-Redistribution and use in source, with or without modification, 
-are permitted provided that the following conditions are met:
-
-Redistributions of source code must retain the above copyright notice, this list 
-of conditions and the following disclaimer.
-
-Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
-to endorse or promote products derived from this software without specific prior 
-written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
-EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
-OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
-SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
-INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
-TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
-BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
-CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
-ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
-
- *  This class allows you to simply add triangles as if this class were a 
- *  container. The AddTriangle() function searches the current list of triangles
- *  and determines if the vertex/normal/texcoord is a duplicate. If so, it addes
- *  an entry to the index array instead of the list of vertices.
- *  When finished, call EndMesh() to free up extra unneeded memory that is reserved
- *  as workspace when you call BeginMesh().
- *
- *  This class can easily be extended to contain other vertex attributes, and to 
- *  save itself and load itself from disk (thus forming the beginnings of a custom
- *  model file format).
- *
- */
- 
- 
-#include "GLTools.h"
-#include "GLTriangleBatch.h"
-#include <assert.h>
-
-
-// Highest 64-bit address. No memory allocation would return this address
-#define NOT_VALID_BUT_USED 0xFFFFFFFFFFFFFFFF
-
-///////////////////////////////////////////////////////////
-// Constructor, does what constructors do... set everything to zero or NULL
-GLTriangleBatch::GLTriangleBatch(void)
-    {
-    nMaxIndexes = 0;
-    nNumIndexes = 0;
-    nNumVerts = 0;
-    
-    bMadeStuff = false;
-	boundingSphereRadius = 0.0f;
-    }
-    
-////////////////////////////////////////////////////////////
-// Free any dynamically allocated memory. For those C programmers
-// coming to C++, it is perfectly valid to delete a NULL pointer.
-GLTriangleBatch::~GLTriangleBatch(void)
-    {
-    // Just in case these still are allocated when the object is destroyed
-    // End does this and leaves the pointers not NULL as a flag as to which
-    // ones were used. Don't uncoment this....
-    if(pIndexes != (GLushort*)NOT_VALID_BUT_USED)
-        delete [] pIndexes;
-
-    if(pVerts != (M3DVector3f*)NOT_VALID_BUT_USED)
-        delete [] pVerts;
-
-    if(pNorms != (M3DVector3f*)NOT_VALID_BUT_USED)
-        delete [] pNorms;
-
-    if(pTexCoords != (M3DVector2f*)NOT_VALID_BUT_USED)
-       delete [] pTexCoords;
-    
-    // Delete buffer objects
-    if(bMadeStuff) {
-        glDeleteVertexArrays(1, &vertexArrayBufferObject);
-        glDeleteBuffers(4, bufferObjects);
-        }
-    }
-    
-////////////////////////////////////////////////////////////
-// Start assembling a mesh. You need to specify a maximum amount
-// of indexes that you expect. The EndMesh will clean up any uneeded
-// memory. This is far better than shreading your heap with STL containers...
-// At least that's my humble opinion.
-void GLTriangleBatch::BeginMesh(GLuint nMaxVerts)
-    {
-#ifdef QT_IS_AVAILABLE
-    initializeOpenGLFunctions();
-#endif
-
-    // Just in case this gets called more than once...
-    if(pIndexes != (GLushort*)NOT_VALID_BUT_USED)
-        delete [] pIndexes;
-
-    if(pVerts != (M3DVector3f*)NOT_VALID_BUT_USED)
-        delete [] pVerts;
-
-    if(pNorms != (M3DVector3f*)NOT_VALID_BUT_USED)
-        delete [] pNorms;
-
-    if(pTexCoords != (M3DVector2f*)NOT_VALID_BUT_USED)
-       delete [] pTexCoords;
-    
-    nMaxIndexes = nMaxVerts;
-    nNumIndexes = 0;
-    nNumVerts = 0;
-    
-    // Pre-allocate new blocks. In reality, the other arrays will be
-    // much shorter than the index array
-    pIndexes = new GLushort[nMaxIndexes];
-    pVerts = new M3DVector3f[nMaxIndexes];
-    pNorms = new M3DVector3f[nMaxIndexes];
-    pTexCoords = new M3DVector2f[nMaxIndexes];
-    }
-  
-/////////////////////////////////////////////////////////////////
-// Add a triangle to the mesh. This searches the current list for identical
-// (well, almost identical - these are floats you know...) verts. If one is found, it
-// is added to the index array. If not, it is added to both the index array and the vertex
-// array grows by one as well.
-// nCheckRange allows for optimizing the search
-void GLTriangleBatch::AddTriangle(M3DVector3f verts[3], M3DVector3f vNorms[3], M3DVector2f vTexCoords[3], float epsilon, int nCheckRange)
-    {
-    // Silently fail unless in debug mode
-    if(nNumIndexes >= nMaxIndexes) {
-        assert(false);
-        return;
-        }
-
-    // First thing we do is make sure the normals are unit length!
-    // It's almost always a good idea to work with pre-normalized normals
-    if(vNorms != nullptr) {
-        m3dNormalizeVector3(vNorms[0]);
-        m3dNormalizeVector3(vNorms[1]);
-        m3dNormalizeVector3(vNorms[2]);
-        }
-
-	// If we.. even once, set texture to NULL, then nothing in the batch has texture coordinates
-    if(vTexCoords == nullptr && pTexCoords != nullptr) {
-		delete [] pTexCoords;
-        pTexCoords = nullptr;
-		}
-        
-    // Ditto for normals
-    if(vNorms == nullptr && pNorms != nullptr) {
-        delete [] pNorms;
-        pNorms = nullptr;
-        }
-
-    // Allow not checking EVERY vertex
-    int nSearchStart = nNumVerts - nCheckRange;
-    if(nSearchStart < 0)
-        nSearchStart = 0;
-
-    // Search for match - triangle consists of three verts
-    for(GLuint iVertex = 0; iVertex < 3; iVertex++) // This is our new triangle
-        {
-        GLuint iMatch = 0;
-        for(iMatch = nSearchStart; iMatch < nNumVerts; iMatch++)   // This is all the triangles that came before
-            {
-            // We have vertexes, texture coordinates, and normals
-			if(pTexCoords && pNorms) {
-				if(m3dCloseEnough(pVerts[iMatch][0], verts[iVertex][0], epsilon) &&
-				   m3dCloseEnough(pVerts[iMatch][1], verts[iVertex][1], epsilon) &&
-				   m3dCloseEnough(pVerts[iMatch][2], verts[iVertex][2], epsilon) &&
-					   
-				   // AND the Normal is the same...
-				   m3dCloseEnough(pNorms[iMatch][0], vNorms[iVertex][0], epsilon) &&
-				   m3dCloseEnough(pNorms[iMatch][1], vNorms[iVertex][1], epsilon) &&
-				   m3dCloseEnough(pNorms[iMatch][2], vNorms[iVertex][2], epsilon) &&
-					   
-					// And Texture is the same...
-					m3dCloseEnough(pTexCoords[iMatch][0], vTexCoords[iVertex][0], epsilon) &&
-					m3dCloseEnough(pTexCoords[iMatch][1], vTexCoords[iVertex][1], epsilon))
-					{
-					// Then add the index only
-					pIndexes[nNumIndexes] = iMatch;
-					nNumIndexes++;
-					break;
-					}
-				}
-
-            // We just have vertexes and normals, no texture
-            if(pNorms && pTexCoords == NULL) {
-                if(m3dCloseEnough(pVerts[iMatch][0], verts[iVertex][0], epsilon) &&
-                   m3dCloseEnough(pVerts[iMatch][1], verts[iVertex][1], epsilon) &&
-                   m3dCloseEnough(pVerts[iMatch][2], verts[iVertex][2], epsilon) &&
-                       
-                   // AND the Normal is the same...
-                   m3dCloseEnough(pNorms[iMatch][0], vNorms[iVertex][0], epsilon) &&
-                   m3dCloseEnough(pNorms[iMatch][1], vNorms[iVertex][1], epsilon) &&
-                   m3dCloseEnough(pNorms[iMatch][2], vNorms[iVertex][2], epsilon))					   
-                    {
-                    // Then add the index only
-                    pIndexes[nNumIndexes] = iMatch;
-                    nNumIndexes++;
-                    break;
-                    }
-                }
-                 
-            // We have vertexes, texture coordinates, and no normals
-            if(pTexCoords && pNorms == NULL) {
-				if(m3dCloseEnough(pVerts[iMatch][0], verts[iVertex][0], epsilon) &&
-				   m3dCloseEnough(pVerts[iMatch][1], verts[iVertex][1], epsilon) &&
-				   m3dCloseEnough(pVerts[iMatch][2], verts[iVertex][2], epsilon) &&
-					   
-					// And Texture is the same...
-					m3dCloseEnough(pTexCoords[iMatch][0], vTexCoords[iVertex][0], epsilon) &&
-					m3dCloseEnough(pTexCoords[iMatch][1], vTexCoords[iVertex][1], epsilon))
-					{
-					// Then add the index only
-					pIndexes[nNumIndexes] = iMatch;
-					nNumIndexes++;
-					break;
-					}
-				}
-                             
-            // Just verts
-            if(pNorms == NULL && pTexCoords == NULL) {
-                if(m3dCloseEnough(pVerts[iMatch][0], verts[iVertex][0], epsilon) &&
-                   m3dCloseEnough(pVerts[iMatch][1], verts[iVertex][1], epsilon) &&
-                   m3dCloseEnough(pVerts[iMatch][2], verts[iVertex][2], epsilon))                       
-                    {
-                    // Then add the index only
-                    pIndexes[nNumIndexes] = iMatch;
-                    nNumIndexes++;
-                    break;
-                    }
-                }   
-            }
-            
-        // No match for this vertex, add to end of list
-        if(iMatch == nNumVerts && nNumVerts < nMaxIndexes && nNumIndexes < nMaxIndexes)
-            {
-            // Always have verts
-            memcpy(pVerts[nNumVerts], verts[iVertex], sizeof(M3DVector3f));
-            
-            // If we have normals
-            if(pNorms)
-                memcpy(pNorms[nNumVerts], vNorms[iVertex], sizeof(M3DVector3f));
-            
-            // if we have texture coordinates
-            if(pTexCoords)
-                memcpy(pTexCoords[nNumVerts], vTexCoords[iVertex], sizeof(M3DVector2f));
-            
-            pIndexes[nNumIndexes] = nNumVerts;
-            nNumIndexes++; 
-            nNumVerts++;
-            }   
-        }
-    }
-    
-
-//////////////////////////////////////////////////////////////////
-// Compact the data. This is a nice utility, but you should really
-// save the results of the indexing for future use if the model data
-// is static (doesn't change).
-void GLTriangleBatch::End(void)
-    {
-    bMadeStuff = true;
-
-    // Find the radius of the smallest sphere that would enclose the model
-    // This is useful for some things.
-    boundingSphereRadius = 0.0f;
-    for(unsigned int i = 0; i < nNumVerts; i++) {
-        GLfloat r = m3dGetVectorLengthSquared3(pVerts[i]);
-        if(r > boundingSphereRadius)
-            boundingSphereRadius = r;
-        }
-    boundingSphereRadius = sqrt(boundingSphereRadius);
-    
-    // Create the buffer objects - might need as many as four
-    glGenBuffers(4, bufferObjects);
-    glGenVertexArrays(1, &vertexArrayBufferObject);
-    glBindVertexArray(vertexArrayBufferObject);
-
-    // Copy data to GPU memory
-    // Vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nNumVerts*3, pVerts, GL_STATIC_DRAW);
-    glVertexAttribPointer(GLT_ATTRIBUTE_VERTEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(GLT_ATTRIBUTE_VERTEX);
-    delete [] pVerts;
-    pVerts = (M3DVector3f*)NOT_VALID_BUT_USED;
-
-
-    // Normal data
-    if(pNorms) {
-        glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[NORMAL_DATA]);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nNumVerts*3, pNorms, GL_STATIC_DRAW);
-        glVertexAttribPointer(GLT_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(GLT_ATTRIBUTE_NORMAL);
-        delete [] pNorms;
-        pNorms = (M3DVector3f*)NOT_VALID_BUT_USED;
-        }
-    else {
-        delete [] pNorms;
-        pNorms = nullptr;
-        }
-
-
-    // Texture coordinates
-    if(pTexCoords) {
-        glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[TEXTURE_DATA]);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nNumVerts*2, pTexCoords, GL_STATIC_DRAW);
-        glVertexAttribPointer(GLT_ATTRIBUTE_TEXTURE0, 2, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(GLT_ATTRIBUTE_TEXTURE0);
-        delete [] pTexCoords;
-        pTexCoords = (M3DVector2f *)NOT_VALID_BUT_USED;
-        }
-        
-    // Indexes
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects[INDEX_DATA]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort)*nNumIndexes, pIndexes, GL_STATIC_DRAW);
-    delete [] pIndexes;
-    pIndexes = (GLushort*)NOT_VALID_BUT_USED;
-
-    glBindVertexArray(0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);	// Note: This should NOT be necessary, it should be captured
-										// in the vertex array object binding state. I believe this is a
-										// bug in iOS's OpenGL implementation, and at it is simply redudant
-										// in other implementations/platforms
-    }
-
-//////////////////////////////////////////////////////////////////////////
-// Submit...
-void GLTriangleBatch::Draw(void)
-    {
-    if(nNumIndexes <= 0)
-        return;
-
-    glBindVertexArray(vertexArrayBufferObject);
-    glDrawElements(GL_TRIANGLES, nNumIndexes, GL_UNSIGNED_SHORT, 0);
-    }
-
-////////////////////////////////////////////////////////////////////////
-// Save the mesh into the already open file stream
-bool GLTriangleBatch::SaveMesh(FILE *pFile)
-    {
-	(void)pFile;
-/*    // Header contains...
-    fwrite(&nNumIndexes, sizeof(GLuint), 1, pFile);
-    fwrite(&nNumVerts, sizeof(GLuint), 1, pFile);
-    fwrite(&boundingSphereRadius, sizeof(GLuint), 1, pFile);
-    
-    
-//    printf("Unique Verts: %d\r\nTriangles: %d\r\n\r\n", nNumVerts, nNumIndexes);
-
-    // Indexes
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects[INDEX_DATA]);
-    pIndexes = (GLushort *)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY);
-    fwrite(pIndexes, sizeof(GLushort) * nNumIndexes, 1, pFile);
-    glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-    pIndexes = NULL;
-    
-    // Vertex positions
-    glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
-    pVerts = (M3DVector3f *)glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
-    fwrite(pVerts, sizeof(M3DVector3f) * nNumVerts, 1, pFile);
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    
-    // Normals, if we have them
-    if(pNorms) { // Look for original flag
-        glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[NORMAL_DATA]);
-        pNorms = (M3DVector3f *)glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
-        fwrite(pNorms, sizeof(M3DVector3f) * nNumVerts, 1, pFile);
-        glUnmapBuffer(GL_ARRAY_BUFFER);
-        }
-        
-    // Texture Coordinates, if we have them
-    if(pTexCoords) { // Look for original flag
-        glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[TEXTURE_DATA]);
-        pTexCoords = (M3DVector2f *)glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
-        fwrite(pTexCoords, sizeof(M3DVector2f) * nNumVerts, 1, pFile);
-        glUnmapBuffer(GL_ARRAY_BUFFER);
-        }
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        
-  */
-    return true;
-    }
-
-
-////////////////////////////////////////////////////////////////////////////////////////////
-// Load a mesh into this batch, given the existing and already opened file stream.
-// So, You must have verts, but normals and vetexes are optional. You need to know
-// ahead of time which are in the file.
-bool GLTriangleBatch::LoadMesh(FILE *pFile, bool bNormals, bool bTexCoords)
-    {
-// In case this is called first (does no harm to call multiple times)
-#ifdef QT_IS_AVAILABLE
-    initializeOpenGLFunctions();
-#endif
-    // Create the buffer objects
-    glGenBuffers(4, bufferObjects);
-    
-    // Create the master vertex array object
-    glGenVertexArrays(1, &vertexArrayBufferObject);
-    glBindVertexArray(vertexArrayBufferObject);
-    
-    // Read it all in
-    fread(&nNumIndexes, sizeof(GLuint), 1, pFile);
-    fread(&nNumVerts, sizeof(GLuint), 1, pFile);
-    fread(&boundingSphereRadius, sizeof(GLuint), 1, pFile);
-    
-//    printf("Unique Verts: %d\r\nTriangles: %d\r\n\r\n", nNumVerts, nNumIndexes);
-    
-    pIndexes = new GLushort[nNumIndexes];
-    fread(pIndexes, sizeof(GLushort) * nNumIndexes, 1, pFile);
-    
-    pVerts = new M3DVector3f[nNumVerts];
-    fread(pVerts, sizeof(M3DVector3f) * nNumVerts, 1, pFile);
-    
-    // Read Normals? If we have them, they occur before the texture coordinates
-    if(bNormals) {
-        pNorms = new M3DVector3f[nNumVerts];
-        if(1 != fread(pNorms, sizeof(M3DVector3f) * nNumVerts, 1, pFile))
-            { // dodo head, no normals
-            delete [] pNorms;
-            pNorms = NULL;
-            }
-        }
-    
-    // These are last, so when loading individual meshes from binary, it's okay if we
-    // just run out of room. However, for multiple meshes in a single file, we need to
-    // know if the mesh has texture coordinates or not. CAD models do not have texture
-    // coordinates.
-    if(bTexCoords) {
-        pTexCoords = new M3DVector2f[nNumVerts];
-        if(1 != fread(pTexCoords, sizeof(M3DVector2f) * nNumVerts, 1, pFile))
-            {		// Sorry, no texture coordinates
-            delete [] pTexCoords;
-            pTexCoords = NULL;
-            }   
-        }
-        
-    // Vertices
-    glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(M3DVector3f) * nNumVerts, pVerts, GL_STATIC_DRAW);
-    delete [] pVerts;
-    
-    // Normals
-    if(pNorms) {
-        glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[NORMAL_DATA]);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(M3DVector3f) * nNumVerts, pNorms, GL_STATIC_DRAW);
-        delete [] pNorms;
-        }
-        
-    // Texture Coordinates
-    if(pTexCoords) {
-        glBindBuffer(GL_ARRAY_BUFFER, bufferObjects[TEXTURE_DATA]);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(M3DVector2f) * nNumVerts, pTexCoords, GL_STATIC_DRAW);
-        delete [] pTexCoords;
-        }
-    
-    // Indexes
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects[INDEX_DATA]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * nNumIndexes, pIndexes, GL_STATIC_DRAW);
-    delete [] pIndexes;
-    
-    return true;
-    }
-
-
-bool GLTriangleBatch::SaveMesh(const char *szFileName)
-	{
-	FILE *pFile;
-	pFile = fopen(szFileName, "wb");
-	if(pFile == NULL)
-		return false;
-        
-    SaveMesh(pFile);
-
-		
-	fclose(pFile);
-	return true;
-	}
-
-
-bool GLTriangleBatch::LoadMesh(const char *szFileName, bool bNormals, bool bTexCoords)
-	{
-	FILE *pFile = fopen(szFileName, "rb");
-	if(pFile == NULL)
-		return false;
-
-    LoadMesh(pFile, bNormals, bTexCoords);
-
-
-    fclose(pFile);
-
-	return true;
-	}
-  
+/*
+ *  GLTriangleBatch.cpp
+ *
+
+Copyright (c) 2007-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source, with or without modification, 
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list 
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used 
+to endorse or promote products derived from this software without specific prior 
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR 
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+ *  This class allows you to simply add triangles as if this class were a 
+ *  container. The AddTriangle() function searches the current list of triangles
+ *  and determines if the vertex/normal/texcoord is a duplicate. If so, it addes
+ *  an entry to the index array instead of the list of vertices.
+ *  When finished, call EndMesh() to free up extra unneeded memory that is reserved
+ *  as workspace when you call BeginMesh().
+ *
+ *  This class can easily be extended to contain other vertex attributes, and to 
+ *  save itself and load itself from disk (thus forming the beginnings of a custom
+ *  model file format).
+ *
+ */
+ 
+// 64-bit off_t for fseeko()/ftello() and mmap() on 32-bit systems, the mesh files can be huge
+#ifndef _WIN32
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "GLTools.h"
+#include "GLTriangleBatch.h"
+#include "GLStateCache.h"
+#include "HalfFloat.h"
+#include <assert.h>
+#include <float.h>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+// Highest 64-bit address. No memory allocation would return this address
+#define NOT_VALID_BUT_USED 0xFFFFFFFFFFFFFFFF
+
+///////////////////////////////////////////////////////////
+// Constructor, does what constructors do... set everything to zero or NULL
+GLTriangleBatch::GLTriangleBatch(void)
+    {
+    nMaxIndexes = 0;
+    nNumIndexes = 0;
+    nNumVerts = 0;
+    indexType = GL_UNSIGNED_SHORT;
+    
+    bMadeStuff = false;
+    bUploading = false;
+    bInterleaved = false;
+	boundingSphereRadius = 0.0f;
+    for(int i = 0; i < 3; i++)
+        vBoundsMin[i] = vBoundsMax[i] = vPositionOffset[i] = 0.0f;
+
+    nCompression = 0;
+    fPositionScale = 1.0f;
+    memset(&compressionReport, 0, sizeof(compressionReport));
+
+    uiInstanceBuffer = 0;
+    nInstanceCount = 0;
+    uiInstanceVAO = 0;
+
+    vertexArrayBufferObject = 0;
+    for(int i = 0; i < 4; i++)
+        bufferObjects[i] = 0;
+
+    nWeldBuckets = 0;
+    nWeldHashed = 0;
+    nWeldThreads = 1;
+    fWeldEpsilon = 0.0f;
+    }
+    
+////////////////////////////////////////////////////////////
+// Free any dynamically allocated memory. For those C programmers
+// coming to C++, it is perfectly valid to delete a NULL pointer.
+GLTriangleBatch::~GLTriangleBatch(void)
+    {
+    // Just in case these still are allocated when the object is destroyed
+    // End does this and leaves the pointers not NULL as a flag as to which
+    // ones were used. Don't uncoment this....
+    if(pIndexes != (GLuint*)NOT_VALID_BUT_USED)
+        delete [] pIndexes;
+
+    if(pVerts != (M3DVector3f*)NOT_VALID_BUT_USED)
+        delete [] pVerts;
+
+    if(pNorms != (M3DVector3f*)NOT_VALID_BUT_USED)
+        delete [] pNorms;
+
+    if(pTexCoords != (M3DVector2f*)NOT_VALID_BUT_USED)
+       delete [] pTexCoords;
+
+    FreeWeldHash();
+    
+    // Delete buffer objects
+    FreeBuffers();
+    }
+
+////////////////////////////////////////////////////////////
+// Delete the buffer objects, the vertex array object, and the instance
+// buffer, whichever of them exist. Loading a mesh into a batch that already
+// has one starts with this, so the old one isn't leaked. Nothing is asked of
+// OpenGL if nothing was ever made.
+void GLTriangleBatch::FreeBuffers(void)
+    {
+    if(vertexArrayBufferObject != 0) {
+        GLStateCache::ForgetVertexArrays(1, &vertexArrayBufferObject);
+        glDeleteVertexArrays(1, &vertexArrayBufferObject);
+        vertexArrayBufferObject = 0;
+        }
+
+    for(int i = 0; i < 4; i++)
+        if(bufferObjects[i] != 0) {
+            GLStateCache::ForgetBuffers(1, &bufferObjects[i]);
+            glDeleteBuffers(1, &bufferObjects[i]);
+            bufferObjects[i] = 0;
+            }
+
+    if(uiInstanceBuffer != 0) {
+        GLStateCache::ForgetBuffers(1, &uiInstanceBuffer);
+        glDeleteBuffers(1, &uiInstanceBuffer);
+        uiInstanceBuffer = 0;
+        }
+
+    nInstanceCount = 0;
+    uiInstanceVAO = 0;
+    bMadeStuff = false;
+    bUploading = false;
+    }
+    
+////////////////////////////////////////////////////////////
+// Start assembling a mesh. You need to specify a maximum amount
+// of indexes that you expect. The EndMesh will clean up any uneeded
+// memory. This is far better than shreading your heap with STL containers...
+// At least that's my humble opinion.
+void GLTriangleBatch::BeginMesh(GLuint nMaxVerts)
+    {
+#ifdef QT_IS_AVAILABLE
+    initializeOpenGLFunctions();
+#endif
+
+    // Just in case this gets called more than once...
+    if(pIndexes != (GLuint*)NOT_VALID_BUT_USED)
+        delete [] pIndexes;
+
+    if(pVerts != (M3DVector3f*)NOT_VALID_BUT_USED)
+        delete [] pVerts;
+
+    if(pNorms != (M3DVector3f*)NOT_VALID_BUT_USED)
+        delete [] pNorms;
+
+    if(pTexCoords != (M3DVector2f*)NOT_VALID_BUT_USED)
+       delete [] pTexCoords;
+    
+    nMaxIndexes = nMaxVerts;
+    nNumIndexes = 0;
+    nNumVerts = 0;
+    
+    // Pre-allocate new blocks. In reality, the other arrays will be
+    // much shorter than the index array
+    pIndexes = new GLuint[nMaxIndexes];
+    pVerts = new M3DVector3f[nMaxIndexes];
+    pNorms = new M3DVector3f[nMaxIndexes];
+    pTexCoords = new M3DVector2f[nMaxIndexes];
+
+    // Weld hash. Size it so the chains stay short even if every index
+    // turns out to be a unique vertex.
+    FreeWeldHash();
+    nWeldBuckets = 64;
+    while(nWeldBuckets < nMaxIndexes && nWeldBuckets < 0x80000000)
+        nWeldBuckets <<= 1;
+
+    pWeldBuckets = new GLuint[nWeldBuckets];
+    pWeldNext = new GLuint[nMaxIndexes];
+    fWeldEpsilon = -1.0f;   // Built on first use
+    }
+  
+/////////////////////////////////////////////////////////////////
+// Pick the smallest index type that can address every vertex. Small meshes
+// stay compact, and big ones don't need to be split into several batches.
+static GLenum IndexTypeForVertexCount(GLuint nVerts)
+    {
+    if(nVerts <= 0x100)
+        return GL_UNSIGNED_BYTE;
+
+    if(nVerts <= 0x10000)
+        return GL_UNSIGNED_SHORT;
+
+    return GL_UNSIGNED_INT;
+    }
+
+static GLuint IndexTypeSize(GLenum type)
+    {
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            return sizeof(GLubyte);
+        case GL_UNSIGNED_SHORT:
+            return sizeof(GLushort);
+        default:
+            return sizeof(GLuint);
+        }
+    }
+
+/////////////////////////////////////////////////////////////////
+// Convert the indexes to indexType (set from nNumVerts) and upload them to the
+// index buffer. The source array can be 1, 2, or 4 bytes per index.
+void GLTriangleBatch::UploadIndexes(const void *pSrc, GLuint nSrcIndexSize)
+    {
+    indexType = IndexTypeForVertexCount(nNumVerts);
+    GLuint nDestIndexSize = IndexTypeSize(indexType);
+
+    GLStateCache::GetStateCache()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects[INDEX_DATA]);
+
+    // Already the right size, no copy needed
+    if(nSrcIndexSize == nDestIndexSize) {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, nDestIndexSize * nNumIndexes, pSrc, GL_STATIC_DRAW);
+        return;
+        }
+
+    GLubyte *pPacked = new GLubyte[nDestIndexSize * nNumIndexes];
+    for(GLuint i = 0; i < nNumIndexes; i++) {
+        GLuint index;
+        switch(nSrcIndexSize) {
+            case sizeof(GLubyte):
+                index = ((const GLubyte *)pSrc)[i];
+                break;
+            case sizeof(GLushort):
+                index = ((const GLushort *)pSrc)[i];
+                break;
+            default:
+                index = ((const GLuint *)pSrc)[i];
+                break;
+            }
+
+        switch(indexType) {
+            case GL_UNSIGNED_BYTE:
+                pPacked[i] = (GLubyte)index;
+                break;
+            case GL_UNSIGNED_SHORT:
+                ((GLushort *)pPacked)[i] = (GLushort)index;
+                break;
+            default:
+                ((GLuint *)pPacked)[i] = index;
+                break;
+            }
+        }
+
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, nDestIndexSize * nNumIndexes, pPacked, GL_STATIC_DRAW);
+    delete [] pPacked;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Weld hash helpers. A vertex lives in the grid cell floor(x / (2 * epsilon)),
+// so anything within epsilon of it is in the same cell or one of the 26
+// neighbors. Only the position is hashed, the normal and texture coordinate
+// are checked by IsSameVertex() like always.
+#define WELD_END 0xFFFFFFFF
+
+// Cells further out than this are all lumped into the last cell on that side
+#define WELD_CELL_LIMIT 1000000000000000000LL
+
+static inline long long WeldCell(GLfloat f, double dInvCellSize)
+    {
+    double d = floor((double)f * dInvCellSize);
+
+    // NaN's never match anything anyway
+    if(d != d)
+        return 0;
+
+    if(d <= -(double)WELD_CELL_LIMIT)
+        return -WELD_CELL_LIMIT;
+
+    if(d >= (double)WELD_CELL_LIMIT)
+        return WELD_CELL_LIMIT;
+
+    return (long long)d;
+    }
+
+static inline GLuint WeldBucket(long long x, long long y, long long z, GLuint nBuckets)
+    {
+    unsigned long long h = ((unsigned long long)x * 73856093ULL) ^
+                           ((unsigned long long)y * 19349663ULL) ^
+                           ((unsigned long long)z * 83492791ULL);
+    return (GLuint)(h ^ (h >> 29)) & (nBuckets - 1);
+    }
+
+void GLTriangleBatch::AddToWeldHash(GLuint iVertex)
+    {
+    double dInvCellSize = 0.5 / fWeldEpsilon;
+    GLuint iBucket = WeldBucket(WeldCell(pVerts[iVertex][0], dInvCellSize),
+                                WeldCell(pVerts[iVertex][1], dInvCellSize),
+                                WeldCell(pVerts[iVertex][2], dInvCellSize), nWeldBuckets);
+
+    // Always added to the head, so each chain runs from highest index to lowest
+    pWeldNext[iVertex] = pWeldBuckets[iBucket];
+    pWeldBuckets[iBucket] = iVertex;
+    }
+
+void GLTriangleBatch::FreeWeldHash(void)
+    {
+    delete [] pWeldBuckets;
+    delete [] pWeldNext;
+    pWeldBuckets = nullptr;
+    pWeldNext = nullptr;
+    nWeldHashed = 0;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Is the vertex at iMatch the same as the one passed in? The positions, and
+// whichever of normals and texture coordinates this batch has, must all be
+// within epsilon of each other. Which attributes to compare is a template
+// parameter, so it's decided once per call instead of once per candidate.
+template<bool bNormals, bool bTexCoords>
+inline bool GLTriangleBatch::IsSameVertex(GLuint iMatch, const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon)
+    {
+    if(!m3dCloseEnough(pVerts[iMatch][0], vVert[0], epsilon) ||
+       !m3dCloseEnough(pVerts[iMatch][1], vVert[1], epsilon) ||
+       !m3dCloseEnough(pVerts[iMatch][2], vVert[2], epsilon))
+        return false;
+
+    // AND the Normal is the same...
+    if(bNormals && (!m3dCloseEnough(pNorms[iMatch][0], vNorm[0], epsilon) ||
+                    !m3dCloseEnough(pNorms[iMatch][1], vNorm[1], epsilon) ||
+                    !m3dCloseEnough(pNorms[iMatch][2], vNorm[2], epsilon)))
+        return false;
+
+    // And Texture is the same...
+    if(bTexCoords && (!m3dCloseEnough(pTexCoords[iMatch][0], vTexCoord[0], epsilon) ||
+                      !m3dCloseEnough(pTexCoords[iMatch][1], vTexCoord[1], epsilon)))
+        return false;
+
+    return true;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Find the lowest numbered vertex from nSearchStart on that matches this one.
+// Returns nNumVerts if there is no match. This gives exactly the same answer
+// as checking every vertex in order, which is what we do if the hash is off.
+template<bool bNormals, bool bTexCoords>
+GLuint GLTriangleBatch::FindWeldMatch(const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon, GLuint nSearchStart)
+    {
+    GLuint iMatch;
+
+    if(!bWeldHash || pWeldBuckets == nullptr) {
+        for(iMatch = nSearchStart; iMatch < nNumVerts; iMatch++)
+            if(IsSameVertex<bNormals, bTexCoords>(iMatch, vVert, vNorm, vTexCoord, epsilon))
+                break;
+
+        return iMatch;
+        }
+
+    // Nothing is ever closer than zero
+    if(!(epsilon > 0.0f))
+        return nNumVerts;
+
+    // Different epsilon, different grid. Start over.
+    if(epsilon != fWeldEpsilon) {
+        for(GLuint i = 0; i < nWeldBuckets; i++)
+            pWeldBuckets[i] = WELD_END;
+
+        fWeldEpsilon = epsilon;
+        nWeldHashed = 0;
+        }
+
+    // Catch up on anything added since the last search
+    while(nWeldHashed < nNumVerts)
+        AddToWeldHash(nWeldHashed++);
+
+    double dInvCellSize = 0.5 / fWeldEpsilon;
+    long long x = WeldCell(vVert[0], dInvCellSize);
+    long long y = WeldCell(vVert[1], dInvCellSize);
+    long long z = WeldCell(vVert[2], dInvCellSize);
+
+    iMatch = nNumVerts;
+    for(long long dx = -1; dx <= 1; dx++)
+        for(long long dy = -1; dy <= 1; dy++)
+            for(long long dz = -1; dz <= 1; dz++) {
+                GLuint iBucket = WeldBucket(x + dx, y + dy, z + dz, nWeldBuckets);
+                for(GLuint i = pWeldBuckets[iBucket]; i != WELD_END && i >= nSearchStart; i = pWeldNext[i])
+                    if(i < iMatch && IsSameVertex<bNormals, bTexCoords>(i, vVert, vNorm, vTexCoord, epsilon))
+                        iMatch = i;
+                }
+
+    return iMatch;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Return the index of the matching vertex, adding it to the end of the list
+// if there isn't one. The caller makes sure there is room.
+template<bool bNormals, bool bTexCoords>
+GLuint GLTriangleBatch::WeldVertex(const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon, GLuint nSearchStart)
+    {
+    GLuint iMatch = FindWeldMatch<bNormals, bTexCoords>(vVert, vNorm, vTexCoord, epsilon, nSearchStart);
+    if(iMatch < nNumVerts)
+        return iMatch;
+
+    // Always have verts
+    memcpy(pVerts[nNumVerts], vVert, sizeof(M3DVector3f));
+
+    // If we have normals
+    if(bNormals)
+        memcpy(pNorms[nNumVerts], vNorm, sizeof(M3DVector3f));
+
+    // if we have texture coordinates
+    if(bTexCoords)
+        memcpy(pTexCoords[nNumVerts], vTexCoord, sizeof(M3DVector2f));
+
+    return nNumVerts++;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Same as above, for when the attributes aren't known until run time
+GLuint GLTriangleBatch::WeldVertex(const GLfloat *vVert, const GLfloat *vNorm, const GLfloat *vTexCoord, float epsilon, GLuint nSearchStart)
+    {
+    if(pNorms && pTexCoords)
+        return WeldVertex<true, true>(vVert, vNorm, vTexCoord, epsilon, nSearchStart);
+
+    if(pNorms)
+        return WeldVertex<true, false>(vVert, vNorm, vTexCoord, epsilon, nSearchStart);
+
+    if(pTexCoords)
+        return WeldVertex<false, true>(vVert, vNorm, vTexCoord, epsilon, nSearchStart);
+
+    return WeldVertex<false, false>(vVert, vNorm, vTexCoord, epsilon, nSearchStart);
+    }
+
+/////////////////////////////////////////////////////////////////
+// If we.. even once, get no texture coordinates (or normals), then nothing
+// in the batch has them
+void GLTriangleBatch::DropMissingAttributes(const void *vNorms, const void *vTexCoords)
+    {
+    if(vTexCoords == nullptr && pTexCoords != nullptr) {
+		delete [] pTexCoords;
+        pTexCoords = nullptr;
+		}
+        
+    // Ditto for normals
+    if(vNorms == nullptr && pNorms != nullptr) {
+        delete [] pNorms;
+        pNorms = nullptr;
+        }
+    }
+
+/////////////////////////////////////////////////////////////////
+// Add a triangle to the mesh. This searches the current list for identical
+// (well, almost identical - these are floats you know...) verts. If one is found, it
+// is added to the index array. If not, it is added to both the index array and the vertex
+// array grows by one as well.
+// nCheckRange allows for optimizing the search
+void GLTriangleBatch::AddTriangle(M3DVector3f verts[3], M3DVector3f vNorms[3], M3DVector2f vTexCoords[3], float epsilon, int nCheckRange)
+    {
+    // Silently fail unless in debug mode
+    if(nNumIndexes >= nMaxIndexes) {
+        assert(false);
+        return;
+        }
+
+    // First thing we do is make sure the normals are unit length!
+    // It's almost always a good idea to work with pre-normalized normals
+    if(vNorms != nullptr) {
+        m3dNormalizeVector3(vNorms[0]);
+        m3dNormalizeVector3(vNorms[1]);
+        m3dNormalizeVector3(vNorms[2]);
+        }
+
+    DropMissingAttributes(vNorms, vTexCoords);
+
+    // Allow not checking EVERY vertex
+    int nSearchStart = nNumVerts - nCheckRange;
+    if(nSearchStart < 0)
+        nSearchStart = 0;
+
+    // Search for match - triangle consists of three verts
+    for(GLuint iVertex = 0; iVertex < 3 && nNumIndexes < nMaxIndexes; iVertex++)
+        {
+        pIndexes[nNumIndexes] = WeldVertex(verts[iVertex], pNorms ? vNorms[iVertex] : nullptr,
+                                           pTexCoords ? vTexCoords[iVertex] : nullptr, epsilon, nSearchStart);
+        nNumIndexes++;
+        }
+    }
+
+/////////////////////////////////////////////////////////////////
+// The work behind AddTriangles() and AddIndexedMesh(). The attributes are
+// sorted out once up front, and then this is one tight loop over the data.
+// Each source vertex is only welded the first time it's used, after that we
+// remember where it went.
+template<bool bNormals, bool bTexCoords>
+void GLTriangleBatch::AddMesh(GLuint nVerts, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords,
+                              GLuint nIndexes, const GLuint *pMeshIndexes, float epsilon)
+    {
+    const GLuint NOT_WELDED = 0xFFFFFFFF;
+    GLuint *pRemap = nullptr;
+    if(pMeshIndexes) {
+        pRemap = new GLuint[nVerts];
+        for(GLuint v = 0; v < nVerts; v++)
+            pRemap[v] = NOT_WELDED;
+        }
+
+    M3DVector3f vNormal;
+    for(GLuint i = 0; i + 3 <= nIndexes; i += 3) {
+        // Silently fail unless in debug mode
+        if(nNumIndexes + 3 > nMaxIndexes) {
+            assert(false);
+            break;
+            }
+
+        for(GLuint iCorner = i; iCorner < i + 3; iCorner++) {
+            GLuint v = pMeshIndexes ? pMeshIndexes[iCorner] : iCorner;
+            assert(v < nVerts);
+
+            if(pRemap && pRemap[v] != NOT_WELDED) {
+                pIndexes[nNumIndexes++] = pRemap[v];
+                continue;
+                }
+
+            // Work with pre-normalized normals, but don't touch the caller's data
+            if(bNormals) {
+                memcpy(vNormal, vNorms[v], sizeof(M3DVector3f));
+                m3dNormalizeVector3(vNormal);
+                }
+
+            GLuint iVertex = WeldVertex<bNormals, bTexCoords>(verts[v], vNormal, bTexCoords ? vTexCoords[v] : nullptr, epsilon, 0);
+            if(pRemap)
+                pRemap[v] = iVertex;
+
+            pIndexes[nNumIndexes++] = iVertex;
+            }
+        }
+
+    delete [] pRemap;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Run fn(nBegin, nEnd, iThread) on nThreads threads, each taking an equal
+// slice of [0, nCount). The slices are always the same for the same nCount.
+template<typename FN>
+static void ParallelFor(GLuint nThreads, size_t nCount, FN fn)
+    {
+    if(nThreads < 2 || nCount < nThreads) {
+        fn(0, nCount, 0);
+        return;
+        }
+
+    size_t nSlice = (nCount + nThreads - 1) / nThreads;
+    std::thread *pThreads = new std::thread[nThreads - 1];
+    for(GLuint t = 1; t < nThreads; t++) {
+        size_t nBegin = (t * nSlice < nCount) ? t * nSlice : nCount;
+        size_t nEnd = (nBegin + nSlice < nCount) ? nBegin + nSlice : nCount;
+        pThreads[t - 1] = std::thread(fn, nBegin, nEnd, t);
+        }
+
+    fn(0, nSlice, 0);
+
+    for(GLuint t = 1; t < nThreads; t++)
+        pThreads[t - 1].join();
+
+    delete [] pThreads;
+    }
+
+struct WELDKEY {
+    GLuint bucket;              // Weld hash bucket of the position
+    GLuint entry;               // Rank of the vertex this came from
+    };
+
+/////////////////////////////////////////////////////////////////
+// Least significant digit radix sort on the bucket, eight bits at a time.
+// Each pass every thread counts its slice, the counts are turned into
+// output positions (digit major, thread minor), and then every thread
+// scatters its slice. It's stable, so a bucket stays in entry order.
+static void ParallelRadixSort(WELDKEY *pKeys, WELDKEY *pScratch, size_t nKeys, GLuint nThreads)
+    {
+    size_t *pCounts = new size_t[nThreads * 256];
+
+    for(int nShift = 0; nShift < 32; nShift += 8) {
+        memset(pCounts, 0, sizeof(size_t) * nThreads * 256);
+
+        ParallelFor(nThreads, nKeys, [=](size_t nBegin, size_t nEnd, GLuint iThread) {
+            size_t *pCount = &pCounts[iThread * 256];
+            for(size_t i = nBegin; i < nEnd; i++)
+                pCount[(pKeys[i].bucket >> nShift) & 0xFF]++;
+            });
+
+        size_t nTotal = 0;
+        for(GLuint nDigit = 0; nDigit < 256; nDigit++)
+            for(GLuint t = 0; t < nThreads; t++) {
+                size_t nCount = pCounts[t * 256 + nDigit];
+                pCounts[t * 256 + nDigit] = nTotal;
+                nTotal += nCount;
+                }
+
+        ParallelFor(nThreads, nKeys, [=](size_t nBegin, size_t nEnd, GLuint iThread) {
+            size_t *pOffset = &pCounts[iThread * 256];
+            for(size_t i = nBegin; i < nEnd; i++)
+                pScratch[pOffset[(pKeys[i].bucket >> nShift) & 0xFF]++] = pKeys[i];
+            });
+
+        WELDKEY *pSwap = pKeys;
+        pKeys = pScratch;
+        pScratch = pSwap;
+        }
+
+    // An even number of passes, so the result ended up back in pKeys
+    delete [] pCounts;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Parallel welding for AddTriangles() and AddIndexedMesh(). The result is
+// exactly what AddMesh() gives, only the searching is shared out. Every
+// vertex taking part gets a rank: the ones already in the batch keep their
+// index, and the new ones follow in the order the mesh first uses them,
+// which is the order the serial weld adds them in.
+// 1. The positions go in the same 2 * epsilon grid as the weld hash, and are
+//    radix sorted by bucket, so each bucket is one run in rank order.
+// 2. Every new vertex finds the lowest ranked vertex it matches in the 27
+//    cells around it. This is most of the work, and the threads split it.
+// 3. In rank order, a vertex is welded to its match if that was kept, and
+//    kept if it has none. If the match was itself welded away the cells are
+//    searched again, for the lowest ranked match that was kept. That is what
+//    the serial weld would have found.
+// 4. The index list is written.
+void GLTriangleBatch::AddMeshParallel(GLuint nVerts, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords,
+                                      GLuint nIndexes, const GLuint *pMeshIndexes, float epsilon)
+    {
+    GLuint nThreads = nWeldThreads;
+    if(nThreads == 0)
+        nThreads = std::thread::hardware_concurrency();
+    if(nThreads == 0)
+        nThreads = 1;
+
+    const GLuint NO_MATCH = 0xFFFFFFFF;
+    const GLuint nExisting = nNumVerts;
+
+    // Rank the new vertices by first use. Ones the mesh never uses don't
+    // take part at all.
+    GLuint *pRank = new GLuint[nVerts];
+    GLuint *pSource = new GLuint[nIndexes];
+    for(GLuint v = 0; v < nVerts; v++)
+        pRank[v] = NO_MATCH;
+
+    GLuint nNew = 0;
+    for(GLuint i = 0; i < nIndexes; i++) {
+        GLuint v = pMeshIndexes ? pMeshIndexes[i] : i;
+        if(pRank[v] == NO_MATCH) {
+            pSource[nNew] = v;
+            pRank[v] = nExisting + nNew++;
+            }
+        }
+
+    const GLuint nEntries = nExisting + nNew;
+
+    // Compare against normalized normals, like AddTriangle() would have,
+    // without touching the caller's data
+    M3DVector3f *pNewNorms = nullptr;
+    if(pNorms) {
+        pNewNorms = new M3DVector3f[nNew ? nNew : 1];
+        ParallelFor(nThreads, nNew, [&](size_t nBegin, size_t nEnd, GLuint) {
+            for(size_t n = nBegin; n < nEnd; n++) {
+                memcpy(pNewNorms[n], vNorms[pSource[n]], sizeof(M3DVector3f));
+                m3dNormalizeVector3(pNewNorms[n]);
+                }
+            });
+        }
+
+    auto Vert = [&](GLuint r) -> const GLfloat * { return (r < nExisting) ? pVerts[r] : verts[pSource[r - nExisting]]; };
+    auto Norm = [&](GLuint r) -> const GLfloat * { return (r < nExisting) ? pNorms[r] : pNewNorms[r - nExisting]; };
+    auto TexCoord = [&](GLuint r) -> const GLfloat * { return (r < nExisting) ? pTexCoords[r] : vTexCoords[pSource[r - nExisting]]; };
+
+    // Same test as IsSameVertex()
+    auto IsSame = [&](GLuint a, GLuint b) {
+        const GLfloat *pA = Vert(a), *pB = Vert(b);
+        for(int i = 0; i < 3; i++)
+            if(!m3dCloseEnough(pA[i], pB[i], epsilon))
+                return false;
+
+        if(pNorms) {
+            pA = Norm(a);
+            pB = Norm(b);
+            for(int i = 0; i < 3; i++)
+                if(!m3dCloseEnough(pA[i], pB[i], epsilon))
+                    return false;
+            }
+
+        if(pTexCoords) {
+            pA = TexCoord(a);
+            pB = TexCoord(b);
+            for(int i = 0; i < 2; i++)
+                if(!m3dCloseEnough(pA[i], pB[i], epsilon))
+                    return false;
+            }
+
+        return true;
+        };
+
+    // What each vertex ends up as, itself if it was kept
+    GLuint *pTarget = new GLuint[nEntries ? nEntries : 1];
+    for(GLuint r = 0; r < nEntries; r++)
+        pTarget[r] = r;
+
+    // Nothing is ever closer than zero
+    if(epsilon > 0.0f && nNew > 0) {
+        GLuint nBuckets = 64;
+        while(nBuckets < nEntries && nBuckets < 0x80000000)
+            nBuckets <<= 1;
+
+        const double dInvCellSize = 0.5 / epsilon;
+        auto GetCell = [&](GLuint r, long long *pCell) {
+            const GLfloat *pVert = Vert(r);
+            for(int i = 0; i < 3; i++)
+                pCell[i] = WeldCell(pVert[i], dInvCellSize);
+            };
+
+        // 1. Bin and sort
+        WELDKEY *pKeys = new WELDKEY[nEntries];
+        ParallelFor(nThreads, nEntries, [&](size_t nBegin, size_t nEnd, GLuint) {
+            long long cell[3];
+            for(size_t r = nBegin; r < nEnd; r++) {
+                GetCell((GLuint)r, cell);
+                pKeys[r].bucket = WeldBucket(cell[0], cell[1], cell[2], nBuckets);
+                pKeys[r].entry = (GLuint)r;
+                }
+            });
+
+        WELDKEY *pScratch = new WELDKEY[nEntries];
+        ParallelRadixSort(pKeys, pScratch, nEntries, nThreads);
+        delete [] pScratch;
+
+        GLuint *pBucketStart = new GLuint[nBuckets];
+        for(GLuint b = 0; b < nBuckets; b++)
+            pBucketStart[b] = NO_MATCH;
+
+        ParallelFor(nThreads, nEntries, [&](size_t nBegin, size_t nEnd, GLuint) {
+            for(size_t i = nBegin; i < nEnd; i++)
+                if(i == 0 || pKeys[i].bucket != pKeys[i - 1].bucket)
+                    pBucketStart[pKeys[i].bucket] = (GLuint)i;
+            });
+
+        // The lowest ranked vertex before r that matches it, and if bKept,
+        // was kept. A bucket is in rank order, so the first match in each
+        // bucket is the lowest there.
+        auto FindMatch = [&](GLuint r, bool bKept) {
+            long long cell[3];
+            GetCell(r, cell);
+
+            GLuint iMatch = NO_MATCH;
+            for(long long dx = -1; dx <= 1; dx++)
+                for(long long dy = -1; dy <= 1; dy++)
+                    for(long long dz = -1; dz <= 1; dz++) {
+                        GLuint b = WeldBucket(cell[0] + dx, cell[1] + dy, cell[2] + dz, nBuckets);
+                        for(GLuint i = pBucketStart[b]; i < nEntries && pKeys[i].bucket == b; i++) {
+                            GLuint m = pKeys[i].entry;
+                            if(m >= r || m >= iMatch)
+                                break;
+
+                            if((!bKept || pTarget[m] == m) && IsSame(r, m)) {
+                                iMatch = m;
+                                break;
+                                }
+                            }
+                        }
+
+            return iMatch;
+            };
+
+        // 2. Search. Only pTarget[r] is written for each r, and nothing reads it yet.
+        ParallelFor(nThreads, nNew, [&](size_t nBegin, size_t nEnd, GLuint) {
+            for(size_t n = nBegin; n < nEnd; n++) {
+                GLuint r = nExisting + (GLuint)n;
+                GLuint m = FindMatch(r, false);
+                if(m != NO_MATCH)
+                    pTarget[r] = m;
+                }
+            });
+
+        // 3. Resolve, in order. Everything before r is final by the time we get to it.
+        for(GLuint r = nExisting; r < nEntries; r++) {
+            GLuint m = pTarget[r];
+            if(m != r && pTarget[m] != m) {
+                m = FindMatch(r, true);
+                pTarget[r] = (m != NO_MATCH) ? m : r;
+                }
+            }
+
+        delete [] pBucketStart;
+        delete [] pKeys;
+        }
+
+    // Kept vertices are added to the batch in rank order, which is first use order
+    GLuint *pSlot = new GLuint[nNew ? nNew : 1];
+    for(GLuint n = 0; n < nNew; n++) {
+        GLuint r = nExisting + n;
+        GLuint m = pTarget[r];
+        if(m < nExisting)
+            pSlot[n] = m;
+        else if(m != r)
+            pSlot[n] = pSlot[m - nExisting];
+        else {
+            memcpy(pVerts[nNumVerts], Vert(r), sizeof(M3DVector3f));
+            if(pNorms)
+                memcpy(pNorms[nNumVerts], Norm(r), sizeof(M3DVector3f));
+            if(pTexCoords)
+                memcpy(pTexCoords[nNumVerts], TexCoord(r), sizeof(M3DVector2f));
+            pSlot[n] = nNumVerts++;
+            }
+        }
+
+    // 4. The indexes. AddIndexedMesh() already made sure they fit.
+    GLuint *pOut = &pIndexes[nNumIndexes];
+    ParallelFor(nThreads, nIndexes, [&](size_t nBegin, size_t nEnd, GLuint) {
+        for(size_t i = nBegin; i < nEnd; i++) {
+            GLuint v = pMeshIndexes ? pMeshIndexes[i] : (GLuint)i;
+            pOut[i] = pSlot[pRank[v] - nExisting];
+            }
+        });
+    nNumIndexes += nIndexes;
+
+    delete [] pSlot;
+    delete [] pTarget;
+    delete [] pNewNorms;
+    delete [] pSource;
+    delete [] pRank;
+    }
+
+/////////////////////////////////////////////////////////////////
+// Add a whole list of triangles in one go. Every three vertices are a
+// triangle. This welds exactly like calling AddTriangle() once per triangle,
+// but without paying for all the per call overhead, and normals are
+// normalized without changing the caller's arrays.
+bool GLTriangleBatch::AddTriangles(GLuint nTriangles, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords, float epsilon)
+    {
+    if(nTriangles > UINT_MAX / 3)
+        return false;
+
+    return AddIndexedMesh(nTriangles * 3, verts, vNorms, vTexCoords, nTriangles * 3, nullptr, epsilon);
+    }
+
+/////////////////////////////////////////////////////////////////
+// Add an indexed mesh (three indexes per triangle). If pMeshIndexes is NULL
+// the vertices are used in order, same as AddTriangles(). The whole thing is
+// checked before anything is added: a count that isn't whole triangles, an
+// index past the end of the vertices, or more than BeginMesh() made room for,
+// and nothing is added and it returns false.
+bool GLTriangleBatch::AddIndexedMesh(GLuint nVerts, const M3DVector3f *verts, const M3DVector3f *vNorms, const M3DVector2f *vTexCoords,
+                                     GLuint nIndexes, const GLuint *pMeshIndexes, float epsilon)
+    {
+    if(nIndexes % 3 != 0 || nIndexes > nMaxIndexes - nNumIndexes)
+        return false;
+
+    if(nIndexes > 0 && verts == nullptr)
+        return false;
+
+    if(pMeshIndexes == nullptr) {
+        if(nIndexes > nVerts)
+            return false;
+        }
+    else
+        for(GLuint i = 0; i < nIndexes; i++)
+            if(pMeshIndexes[i] >= nVerts)
+                return false;
+
+    DropMissingAttributes(vNorms, vTexCoords);
+
+    if(nWeldThreads != 1)
+        AddMeshParallel(nVerts, verts, vNorms, vTexCoords, nIndexes, pMeshIndexes, epsilon);
+    else if(pNorms && pTexCoords)
+        AddMesh<true, true>(nVerts, verts, vNorms, vTexCoords, nIndexes, pMeshIndexes, epsilon);
+    else if(pNorms)
+        AddMesh<true, false>(nVerts, verts, vNorms, vTexCoords, nIndexes, pMeshIndexes, epsilon);
+    else if(pTexCoords)
+        AddMesh<false, true>(nVerts, verts, vNorms, vTexCoords, nIndexes, pMeshIndexes, epsilon);
+    else
+        AddMesh<false, false>(nVerts, verts, vNorms, vTexCoords, nIndexes, pMeshIndexes, epsilon);
+
+    return true;
+    }
+    
+
+//////////////////////////////////////////////////////////////////
+// Post-transform vertex cache optimization. This is Tom Forsyth's "Linear-Speed
+// Vertex Cache Optimisation". Each vertex gets a score based on where it is in
+// a simulated LRU cache and how many triangles still need it, and we greedily
+// emit whichever triangle touching the cache has the highest total score.
+#define VCACHE_SIZE         32      // Simulated LRU size used to pick triangles
+#define VCACHE_FIFO_SIZE    16      // FIFO size used to measure the ACMR
+
+static float VertexCacheScore(int nCachePosition, GLuint nValence)
+    {
+    // Nothing left to draw with this one
+    if(nValence == 0)
+        return -1.0f;
+
+    float fScore = 0.0f;
+    if(nCachePosition >= 0) {
+        // Used by the last triangle. Don't want to favor it too much, or we end
+        // up drawing strips that keep coming back to the same vertices
+        if(nCachePosition < 3)
+            fScore = 0.75f;
+        else
+            fScore = powf(1.0f - (float)(nCachePosition - 3) / (float)(VCACHE_SIZE - 3), 1.5f);
+        }
+
+    // Boost vertices with only a few triangles left, so we finish them off
+    // instead of leaving lonely triangles around to draw later
+    fScore += 2.0f * powf((float)nValence, -0.5f);
+    return fScore;
+    }
+
+static void OptimizeVertexCache(GLuint *pIndexes, GLuint nNumIndexes, GLuint nNumVerts)
+    {
+    GLuint nTris = nNumIndexes / 3;
+    if(nTris == 0)
+        return;
+
+    // Triangles that use each vertex. pValence counts the ones not drawn yet,
+    // and they are always kept at the front of each vertex's list.
+    GLuint *pValence = new GLuint[nNumVerts];
+    GLuint *pAdjStart = new GLuint[nNumVerts + 1];
+    GLuint *pAdj = new GLuint[nTris * 3];
+    memset(pValence, 0, sizeof(GLuint) * nNumVerts);
+
+    for(GLuint i = 0; i < nTris * 3; i++)
+        pValence[pIndexes[i]]++;
+
+    pAdjStart[0] = 0;
+    for(GLuint v = 0; v < nNumVerts; v++) {
+        pAdjStart[v + 1] = pAdjStart[v] + pValence[v];
+        pValence[v] = 0;
+        }
+
+    for(GLuint i = 0; i < nTris * 3; i++) {
+        GLuint v = pIndexes[i];
+        pAdj[pAdjStart[v] + pValence[v]] = i / 3;
+        pValence[v]++;
+        }
+
+    int *pCachePosition = new int[nNumVerts];
+    float *pVertexScore = new float[nNumVerts];
+    for(GLuint v = 0; v < nNumVerts; v++) {
+        pCachePosition[v] = -1;
+        pVertexScore[v] = VertexCacheScore(-1, pValence[v]);
+        }
+
+    float *pTriScore = new float[nTris];
+    bool *pTriAdded = new bool[nTris];
+    for(GLuint t = 0; t < nTris; t++) {
+        pTriScore[t] = pVertexScore[pIndexes[t*3]] + pVertexScore[pIndexes[t*3+1]] + pVertexScore[pIndexes[t*3+2]];
+        pTriAdded[t] = false;
+        }
+
+    GLuint *pNewIndexes = new GLuint[nTris * 3];
+    GLuint cache[VCACHE_SIZE + 3];
+    GLuint newCache[VCACHE_SIZE + 3];
+    GLuint nCached = 0;
+    GLuint nScanFrom = 0;   // No triangles before this are left to draw
+    int iBest = -1;
+
+    for(GLuint nDrawn = 0; nDrawn < nTris; nDrawn++) {
+        // Nothing in the cache is any use, just take the next triangle left
+        if(iBest < 0) {
+            while(pTriAdded[nScanFrom])
+                nScanFrom++;
+            iBest = (int)nScanFrom;
+            }
+
+        GLuint *pTri = &pIndexes[iBest * 3];
+        memcpy(&pNewIndexes[nDrawn * 3], pTri, sizeof(GLuint) * 3);
+        pTriAdded[iBest] = true;
+
+        // This triangle is done, take it off each of its vertices' lists
+        for(int i = 0; i < 3; i++) {
+            GLuint v = pTri[i];
+            GLuint *pList = &pAdj[pAdjStart[v]];
+            for(GLuint j = 0; j < pValence[v]; j++)
+                if(pList[j] == (GLuint)iBest) {
+                    pList[j] = pList[pValence[v] - 1];
+                    pList[pValence[v] - 1] = (GLuint)iBest;
+                    break;
+                    }
+            pValence[v]--;
+            }
+
+        // The triangle's vertices go to the front of the cache, everything
+        // else moves back. Anything pushed off the end is evicted.
+        GLuint nNewCached = 0;
+        for(int i = 0; i < 3; i++)
+            newCache[nNewCached++] = pTri[i];
+
+        for(GLuint i = 0; i < nCached; i++)
+            if(cache[i] != pTri[0] && cache[i] != pTri[1] && cache[i] != pTri[2])
+                newCache[nNewCached++] = cache[i];
+
+        // Rescore whatever moved, and pass the change on to its triangles
+        iBest = -1;
+        float fBestScore = -1.0f;
+        for(GLuint i = 0; i < nNewCached; i++) {
+            GLuint v = newCache[i];
+            pCachePosition[v] = (i < VCACHE_SIZE) ? (int)i : -1;
+
+            float fScore = VertexCacheScore(pCachePosition[v], pValence[v]);
+            float fDelta = fScore - pVertexScore[v];
+            pVertexScore[v] = fScore;
+
+            for(GLuint j = 0; j < pValence[v]; j++) {
+                GLuint t = pAdj[pAdjStart[v] + j];
+                pTriScore[t] += fDelta;
+
+                if(i < VCACHE_SIZE && pTriScore[t] > fBestScore) {
+                    fBestScore = pTriScore[t];
+                    iBest = (int)t;
+                    }
+                }
+            }
+
+        nCached = (nNewCached < VCACHE_SIZE) ? nNewCached : VCACHE_SIZE;
+        memcpy(cache, newCache, sizeof(GLuint) * nCached);
+        }
+
+    memcpy(pIndexes, pNewIndexes, sizeof(GLuint) * nTris * 3);
+
+    delete [] pNewIndexes;
+    delete [] pTriAdded;
+    delete [] pTriScore;
+    delete [] pVertexScore;
+    delete [] pCachePosition;
+    delete [] pAdj;
+    delete [] pAdjStart;
+    delete [] pValence;
+    }
+
+//////////////////////////////////////////////////////////////////
+// Average cache miss ratio, the number of vertices the GPU has to transform per
+// triangle, with a simple FIFO cache like most hardware has. 3.0 is the worst
+// you can do, 0.5 is about the best for a large regular mesh.
+static GLfloat ComputeACMR(const GLuint *pIndexes, GLuint nNumIndexes, GLuint nNumVerts)
+    {
+    GLuint nTris = nNumIndexes / 3;
+    if(nTris == 0)
+        return 0.0f;
+
+    // A vertex is in the cache if fewer than VCACHE_FIFO_SIZE misses have
+    // happened since it was loaded
+    GLuint *pLoadedAt = new GLuint[nNumVerts];
+    memset(pLoadedAt, 0, sizeof(GLuint) * nNumVerts);
+
+    GLuint nMisses = 0;
+    GLuint nTime = VCACHE_FIFO_SIZE + 1;
+    for(GLuint i = 0; i < nTris * 3; i++) {
+        GLuint v = pIndexes[i];
+        if(nTime - pLoadedAt[v] > VCACHE_FIFO_SIZE) {
+            pLoadedAt[v] = nTime++;
+            nMisses++;
+            }
+        }
+
+    delete [] pLoadedAt;
+    return (GLfloat)nMisses / (GLfloat)nTris;
+    }
+
+//////////////////////////////////////////////////////////////////
+// Renumber the vertices in the order the index buffer first uses them, so
+// walking the indexes walks forward through the vertex arrays. Any vertex the
+// indexes never reference is dropped. Do this after any triangle reordering.
+void GLTriangleBatch::OptimizeVertexFetch(void)
+    {
+    const GLuint NOT_USED = 0xFFFFFFFF;
+    GLuint *pRemap = new GLuint[nNumVerts];
+    for(GLuint v = 0; v < nNumVerts; v++)
+        pRemap[v] = NOT_USED;
+
+    GLuint nNewVerts = 0;
+    for(GLuint i = 0; i < nNumIndexes; i++) {
+        GLuint v = pIndexes[i];
+        if(pRemap[v] == NOT_USED)
+            pRemap[v] = nNewVerts++;
+
+        pIndexes[i] = pRemap[v];
+        }
+
+    // New arrays, just big enough
+    M3DVector3f *pNewVerts = new M3DVector3f[nNewVerts];
+    M3DVector3f *pNewNorms = pNorms ? new M3DVector3f[nNewVerts] : nullptr;
+    M3DVector2f *pNewTexCoords = pTexCoords ? new M3DVector2f[nNewVerts] : nullptr;
+
+    for(GLuint v = 0; v < nNumVerts; v++) {
+        GLuint n = pRemap[v];
+        if(n == NOT_USED)
+            continue;
+
+        memcpy(pNewVerts[n], pVerts[v], sizeof(M3DVector3f));
+
+        if(pNorms)
+            memcpy(pNewNorms[n], pNorms[v], sizeof(M3DVector3f));
+
+        if(pTexCoords)
+            memcpy(pNewTexCoords[n], pTexCoords[v], sizeof(M3DVector2f));
+        }
+
+    delete [] pVerts;
+    delete [] pNorms;
+    delete [] pTexCoords;
+    pVerts = pNewVerts;
+    pNorms = pNewNorms;
+    pTexCoords = pNewTexCoords;
+
+    nNumVerts = nNewVerts;
+    delete [] pRemap;
+    }
+
+//////////////////////////////////////////////////////////////////
+// Put positions, normals, and texture coordinates for each vertex next to
+// each other in a single buffer (32 bytes a vertex when we have all three),
+// so drawing reads one stream of memory instead of three.
+void GLTriangleBatch::UploadInterleaved(void)
+    {
+    GLuint nStride = sizeof(M3DVector3f);
+    GLuint nNormalOffset = nStride;
+    if(pNorms)
+        nStride += sizeof(M3DVector3f);
+
+    GLuint nTexCoordOffset = nStride;
+    if(pTexCoords)
+        nStride += sizeof(M3DVector2f);
+
+    GLubyte *pInterleaved = new GLubyte[nStride * nNumVerts];
+    for(GLuint i = 0; i < nNumVerts; i++) {
+        GLubyte *pVertex = pInterleaved + (i * nStride);
+        memcpy(pVertex, pVerts[i], sizeof(M3DVector3f));
+
+        if(pNorms)
+            memcpy(pVertex + nNormalOffset, pNorms[i], sizeof(M3DVector3f));
+
+        if(pTexCoords)
+            memcpy(pVertex + nTexCoordOffset, pTexCoords[i], sizeof(M3DVector2f));
+        }
+
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
+    glBufferData(GL_ARRAY_BUFFER, nStride * nNumVerts, pInterleaved, GL_STATIC_DRAW);
+    delete [] pInterleaved;
+
+    glVertexAttribPointer(GLT_ATTRIBUTE_VERTEX, 3, GL_FLOAT, GL_FALSE, nStride, 0);
+    glEnableVertexAttribArray(GLT_ATTRIBUTE_VERTEX);
+
+    if(pNorms) {
+        glVertexAttribPointer(GLT_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, nStride, (const GLvoid *)(size_t)nNormalOffset);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_NORMAL);
+        }
+
+    if(pTexCoords) {
+        glVertexAttribPointer(GLT_ATTRIBUTE_TEXTURE0, 2, GL_FLOAT, GL_FALSE, nStride, (const GLvoid *)(size_t)nTexCoordOffset);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_TEXTURE0);
+        }
+    }
+
+//////////////////////////////////////////////////////////////////
+// One buffer for each attribute. Normals and texture coordinates are
+// optional, pass NULL if there aren't any.
+void GLTriangleBatch::UploadPlanar(const GLvoid *pVertData, const GLvoid *pNormData, const GLvoid *pTexData)
+    {
+    // Vertex data
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nNumVerts*3, pVertData, GL_STATIC_DRAW);
+    glVertexAttribPointer(GLT_ATTRIBUTE_VERTEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(GLT_ATTRIBUTE_VERTEX);
+
+    // Normal data
+    if(pNormData) {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[NORMAL_DATA]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nNumVerts*3, pNormData, GL_STATIC_DRAW);
+        glVertexAttribPointer(GLT_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_NORMAL);
+        }
+
+    // Texture coordinates
+    if(pTexData) {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[TEXTURE_DATA]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nNumVerts*2, pTexData, GL_STATIC_DRAW);
+        glVertexAttribPointer(GLT_ATTRIBUTE_TEXTURE0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_TEXTURE0);
+        }
+    }
+
+//////////////////////////////////////////////////////////////////
+// Compressed vertex formats. Positions are shorts, normalized to the bounding
+// box (decoded by GetPositionDecodeMatrix()), normals are 10:10:10:2 signed
+// normalized, and texture coordinates are half floats. Any attribute without
+// its GLT_BATCH_COMPRESS_ flag stays as floats. The worst error of each one is
+// kept for GetCompressionReport().
+#define GLT_POSITION_QUANT      32767.0f
+#define GLT_NORMAL_QUANT        511.0f
+
+static inline GLshort QuantizePosition(GLfloat f)
+    {
+    GLfloat q = floorf(f * GLT_POSITION_QUANT + 0.5f);
+    if(q > GLT_POSITION_QUANT)
+        q = GLT_POSITION_QUANT;
+    if(q < -GLT_POSITION_QUANT)
+        q = -GLT_POSITION_QUANT;
+    return (GLshort)q;
+    }
+
+static inline GLint QuantizeNormal(GLfloat f)
+    {
+    GLfloat q = floorf(f * GLT_NORMAL_QUANT + 0.5f);
+    if(q > GLT_NORMAL_QUANT)
+        q = GLT_NORMAL_QUANT;
+    if(q < -GLT_NORMAL_QUANT)
+        q = -GLT_NORMAL_QUANT;
+    return (GLint)q;
+    }
+
+// Signed normalized decode, the way OpenGL does it
+static inline GLfloat DequantizeNormal(GLint n)
+    {
+    GLfloat f = (GLfloat)n / GLT_NORMAL_QUANT;
+    return (f < -1.0f) ? -1.0f : f;
+    }
+
+void GLTriangleBatch::UploadCompressed(GLuint nCompress)
+    {
+    memset(&compressionReport, 0, sizeof(compressionReport));
+
+    // Positions relative to the center of the box, one scale for all axes so
+    // the decode matrix doesn't skew the normals
+    fPositionScale = 0.0f;
+    for(int j = 0; j < 3; j++) {
+        vPositionOffset[j] = (vBoundsMin[j] + vBoundsMax[j]) * 0.5f;
+        GLfloat fHalf = (vBoundsMax[j] - vBoundsMin[j]) * 0.5f;
+        if(fHalf > fPositionScale)
+            fPositionScale = fHalf;
+        }
+    if(!(fPositionScale > 0.0f))
+        fPositionScale = 1.0f;
+
+    // Interleaved vertices need 4 byte alignment, so positions get a 4th
+    // component (w, always 1.0)
+    GLuint nPosComponents = (bInterleaved) ? 4 : 3;
+    GLuint nPosSize = (nCompress & GLT_BATCH_COMPRESS_POSITIONS) ? sizeof(GLshort) * nPosComponents : sizeof(M3DVector3f);
+    GLuint nNormSize = (nCompress & GLT_BATCH_COMPRESS_NORMALS) ? sizeof(GLuint) : sizeof(M3DVector3f);
+    GLuint nTexSize = (nCompress & GLT_BATCH_COMPRESS_TEXCOORDS) ? sizeof(hfloat) * 2 : sizeof(M3DVector2f);
+    if(!pNorms)
+        nNormSize = 0;
+    if(!pTexCoords)
+        nTexSize = 0;
+
+    // Where everything goes
+    GLuint nStride = nPosSize + nNormSize + nTexSize;
+    GLuint nPosStride = nPosSize, nNormStride = nNormSize, nTexStride = nTexSize;
+    GLuint nNormOffset = 0, nTexOffset = 0;
+    GLubyte *pPosData = new GLubyte[nStride * nNumVerts];
+    GLubyte *pNormData = pPosData + nPosSize * nNumVerts;
+    GLubyte *pTexData = pNormData + nNormSize * nNumVerts;
+    if(bInterleaved) {
+        nPosStride = nNormStride = nTexStride = nStride;
+        nNormOffset = nPosSize;
+        nTexOffset = nPosSize + nNormSize;
+        pNormData = pPosData + nNormOffset;
+        pTexData = pPosData + nTexOffset;
+        }
+
+    GLfloat fInvScale = 1.0f / fPositionScale;
+    for(GLuint i = 0; i < nNumVerts; i++) {
+        GLubyte *pPos = pPosData + i * nPosStride;
+        if(nCompress & GLT_BATCH_COMPRESS_POSITIONS) {
+            GLshort *pShorts = (GLshort *)pPos;
+            for(int j = 0; j < 3; j++) {
+                pShorts[j] = QuantizePosition((pVerts[i][j] - vPositionOffset[j]) * fInvScale);
+
+                GLfloat fDecoded = vPositionOffset[j] + ((GLfloat)pShorts[j] / GLT_POSITION_QUANT) * fPositionScale;
+                GLfloat fError = fabsf(fDecoded - pVerts[i][j]);
+                if(fError > compressionReport.fMaxPositionError)
+                    compressionReport.fMaxPositionError = fError;
+                }
+            if(nPosComponents == 4)
+                pShorts[3] = (GLshort)GLT_POSITION_QUANT;
+            }
+        else
+            memcpy(pPos, pVerts[i], sizeof(M3DVector3f));
+
+        if(pNorms) {
+            GLubyte *pNorm = pNormData + i * nNormStride;
+            if(nCompress & GLT_BATCH_COMPRESS_NORMALS) {
+                GLint n[3];
+                for(int j = 0; j < 3; j++) {
+                    n[j] = QuantizeNormal(pNorms[i][j]);
+
+                    GLfloat fError = fabsf(DequantizeNormal(n[j]) - pNorms[i][j]);
+                    if(fError > compressionReport.fMaxNormalError)
+                        compressionReport.fMaxNormalError = fError;
+                    }
+
+                GLuint nPacked = ((GLuint)n[0] & 0x3FF) | (((GLuint)n[1] & 0x3FF) << 10) | (((GLuint)n[2] & 0x3FF) << 20);
+                memcpy(pNorm, &nPacked, sizeof(GLuint));
+                }
+            else
+                memcpy(pNorm, pNorms[i], sizeof(M3DVector3f));
+            }
+
+        if(pTexCoords) {
+            GLubyte *pTex = pTexData + i * nTexStride;
+            if(nCompress & GLT_BATCH_COMPRESS_TEXCOORDS) {
+                hfloat h[2];
+                M3DVector2f vDecoded;
+                convertFloatToHFloatN(pTexCoords[i], h, 2);
+                convertHFloatToFloatN(h, vDecoded, 2);
+                for(int j = 0; j < 2; j++) {
+                    GLfloat fError = fabsf(vDecoded[j] - pTexCoords[i][j]);
+                    if(fError > compressionReport.fMaxTexCoordError)
+                        compressionReport.fMaxTexCoordError = fError;
+                    }
+                memcpy(pTex, h, sizeof(h));
+                }
+            else
+                memcpy(pTex, pTexCoords[i], sizeof(M3DVector2f));
+            }
+        }
+
+    // One buffer, or three
+    if(bInterleaved) {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
+        glBufferData(GL_ARRAY_BUFFER, nStride * nNumVerts, pPosData, GL_STATIC_DRAW);
+        }
+    else {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
+        glBufferData(GL_ARRAY_BUFFER, nPosSize * nNumVerts, pPosData, GL_STATIC_DRAW);
+        }
+
+    if(nCompress & GLT_BATCH_COMPRESS_POSITIONS)
+        glVertexAttribPointer(GLT_ATTRIBUTE_VERTEX, nPosComponents, GL_SHORT, GL_TRUE, nPosStride, 0);
+    else
+        glVertexAttribPointer(GLT_ATTRIBUTE_VERTEX, 3, GL_FLOAT, GL_FALSE, nPosStride, 0);
+    glEnableVertexAttribArray(GLT_ATTRIBUTE_VERTEX);
+
+    if(pNorms) {
+        if(!bInterleaved) {
+            GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[NORMAL_DATA]);
+            glBufferData(GL_ARRAY_BUFFER, nNormSize * nNumVerts, pNormData, GL_STATIC_DRAW);
+            }
+
+        if(nCompress & GLT_BATCH_COMPRESS_NORMALS)
+            glVertexAttribPointer(GLT_ATTRIBUTE_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, nNormStride, (const GLvoid *)(size_t)nNormOffset);
+        else
+            glVertexAttribPointer(GLT_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, nNormStride, (const GLvoid *)(size_t)nNormOffset);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_NORMAL);
+        }
+
+    if(pTexCoords) {
+        if(!bInterleaved) {
+            GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[TEXTURE_DATA]);
+            glBufferData(GL_ARRAY_BUFFER, nTexSize * nNumVerts, pTexData, GL_STATIC_DRAW);
+            }
+
+        if(nCompress & GLT_BATCH_COMPRESS_TEXCOORDS)
+            glVertexAttribPointer(GLT_ATTRIBUTE_TEXTURE0, 2, GL_HALF_FLOAT, GL_FALSE, nTexStride, (const GLvoid *)(size_t)nTexOffset);
+        else
+            glVertexAttribPointer(GLT_ATTRIBUTE_TEXTURE0, 2, GL_FLOAT, GL_FALSE, nTexStride, (const GLvoid *)(size_t)nTexOffset);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_TEXTURE0);
+        }
+
+    delete [] pPosData;
+
+    compressionReport.nVertexBytes = nStride * nNumVerts;
+    compressionReport.nUncompressedBytes = (GLuint)(sizeof(M3DVector3f) + (pNorms ? sizeof(M3DVector3f) : 0) +
+                                                    (pTexCoords ? sizeof(M3DVector2f) : 0)) * nNumVerts;
+    }
+
+//////////////////////////////////////////////////////////////////
+// The matrix that takes compressed positions back to model space. Put it on
+// the right of the model(view) matrix. It's the identity if positions aren't
+// compressed. The scale is uniform, so normal matrices are not affected.
+void GLTriangleBatch::GetPositionDecodeMatrix(M3DMatrix44f mDecode)
+    {
+    for(int i = 0; i < 16; i++)
+        mDecode[i] = 0.0f;
+
+    GLfloat fScale = (nCompression & GLT_BATCH_COMPRESS_POSITIONS) ? fPositionScale : 1.0f;
+    mDecode[0] = mDecode[5] = mDecode[10] = fScale;
+    mDecode[15] = 1.0f;
+
+    if(nCompression & GLT_BATCH_COMPRESS_POSITIONS) {
+        mDecode[12] = vPositionOffset[0];
+        mDecode[13] = vPositionOffset[1];
+        mDecode[14] = vPositionOffset[2];
+        }
+    }
+
+//////////////////////////////////////////////////////////////////
+// Compact the data. This is a nice utility, but you should really
+// save the results of the indexing for future use if the model data
+// is static (doesn't change).
+// nOptions is zero or more of the GLT_BATCH_ flags or'ed together.
+void GLTriangleBatch::End(GLuint nOptions)
+    {
+    // A batch can be built more than once, don't leak the last one
+    FreeBuffers();
+    bMadeStuff = true;
+    FreeWeldHash();
+
+    // Create the buffer objects - might need as many as four
+    glGenBuffers(4, bufferObjects);
+    glGenVertexArrays(1, &vertexArrayBufferObject);
+    GLStateCache::GetStateCache()->BindVertexArray(vertexArrayBufferObject);
+
+    // Reorder the triangles for the post-transform cache
+    fACMRBefore = fACMRAfter = 0.0f;
+    if(nOptions & GLT_BATCH_OPTIMIZE_VCACHE) {
+        fACMRBefore = ComputeACMR(pIndexes, nNumIndexes, nNumVerts);
+        OptimizeVertexCache(pIndexes, nNumIndexes, nNumVerts);
+        fACMRAfter = ComputeACMR(pIndexes, nNumIndexes, nNumVerts);
+        }
+
+    // And the vertices for the pre-transform (fetch) cache
+    if(nOptions & GLT_BATCH_OPTIMIZE_VFETCH)
+        OptimizeVertexFetch();
+
+    // Find the radius of the smallest sphere that would enclose the model
+    // This is useful for some things. So is the bounding box. Only the
+    // vertices left after OptimizeVertexFetch() count, and the compressed
+    // positions need it.
+    boundingSphereRadius = 0.0f;
+    for(int j = 0; j < 3; j++) {
+        vBoundsMin[j] = (nNumVerts > 0) ? pVerts[0][j] : 0.0f;
+        vBoundsMax[j] = vBoundsMin[j];
+        }
+
+    for(unsigned int i = 0; i < nNumVerts; i++) {
+        GLfloat r = m3dGetVectorLengthSquared3(pVerts[i]);
+        if(r > boundingSphereRadius)
+            boundingSphereRadius = r;
+
+        for(int j = 0; j < 3; j++) {
+            if(pVerts[i][j] < vBoundsMin[j])
+                vBoundsMin[j] = pVerts[i][j];
+            if(pVerts[i][j] > vBoundsMax[j])
+                vBoundsMax[j] = pVerts[i][j];
+            }
+        }
+    boundingSphereRadius = sqrt(boundingSphereRadius);
+
+    // Copy data to GPU memory
+    bInterleaved = (nOptions & GLT_BATCH_INTERLEAVED) != 0;
+    nCompression = nOptions & GLT_BATCH_COMPRESS;
+    if(nCompression)
+        UploadCompressed(nCompression);
+    else if(bInterleaved)
+        UploadInterleaved();
+    else
+        UploadPlanar(pVerts, pNorms, pTexCoords);
+
+    delete [] pVerts;
+    pVerts = (M3DVector3f*)NOT_VALID_BUT_USED;
+
+    if(pNorms) {
+        delete [] pNorms;
+        pNorms = (M3DVector3f*)NOT_VALID_BUT_USED;
+        }
+
+    if(pTexCoords) {
+        delete [] pTexCoords;
+        pTexCoords = (M3DVector2f *)NOT_VALID_BUT_USED;
+        }
+        
+    // Indexes
+    UploadIndexes(pIndexes, sizeof(GLuint));
+    delete [] pIndexes;
+    pIndexes = (GLuint*)NOT_VALID_BUT_USED;
+
+    GLStateCache::GetStateCache()->BindVertexArray(0);
+	GLStateCache::GetStateCache()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, 0);	// Note: This should NOT be necessary, it should be captured
+										// in the vertex array object binding state. I believe this is a
+										// bug in iOS's OpenGL implementation, and at it is simply redudant
+										// in other implementations/platforms
+    }
+
+//////////////////////////////////////////////////////////////////////////
+// Submit...
+void GLTriangleBatch::Draw(void)
+    {
+    if(nNumIndexes <= 0 || !bMadeStuff)
+        return;
+
+    GLStateCache::GetStateCache()->BindVertexArray(vertexArrayBufferObject);
+    glDrawElements(GL_TRIANGLES, nNumIndexes, indexType, 0);
+    }
+
+//////////////////////////////////////////////////////////////////////////
+// Fill the instance buffer. It's orphaned and rewritten every time, so
+// changing it each frame doesn't wait on the draws still using the old one.
+void GLTriangleBatch::SetInstanceData(GLuint nInstances, const M3DMatrix44f *pTransforms, const M3DVector4f *pColors)
+    {
+    nInstanceCount = 0;
+    if(!bMadeStuff || nInstances == 0 || pTransforms == NULL)
+        return;
+
+    if(uiInstanceBuffer == 0)
+        glGenBuffers(1, &uiInstanceBuffer);
+
+    GLsizeiptr nSize = sizeof(GLTINSTANCEDATA) * nInstances;
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, uiInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, nSize, NULL, GL_DYNAMIC_DRAW);
+
+    GLTINSTANCEDATA *pInstances = (GLTINSTANCEDATA*)glMapBufferRange(GL_ARRAY_BUFFER, 0, nSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(pInstances == NULL)
+        return;
+
+    for(GLuint i = 0; i < nInstances; i++) {
+        memcpy(pInstances[i].mTransform, pTransforms[i], sizeof(M3DMatrix44f));
+        if(pColors != NULL)
+            memcpy(pInstances[i].vColor, pColors[i], sizeof(M3DVector4f));
+        else
+            pInstances[i].vColor[0] = pInstances[i].vColor[1] = pInstances[i].vColor[2] = pInstances[i].vColor[3] = 1.0f;
+        }
+
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    nInstanceCount = nInstances;
+
+    if(uiInstanceVAO != vertexArrayBufferObject)
+        AttachInstanceData();
+    }
+
+//////////////////////////////////////////////////////////////////////////
+// Point the instance attributes at the instance buffer, one step per
+// instance instead of per vertex. This is vertex array state, so it only
+// has to be done again if the mesh is loaded into a new one. FreeBuffers()
+// zeroes uiInstanceVAO, so a new vertex array that happens to get the old
+// name still gets set up.
+void GLTriangleBatch::AttachInstanceData(void)
+    {
+    GLStateCache *pStateCache = GLStateCache::GetStateCache();
+    pStateCache->BindVertexArray(vertexArrayBufferObject);
+    pStateCache->BindBuffer(GL_ARRAY_BUFFER, uiInstanceBuffer);
+
+    // A mat4 attribute is four vec4 columns in a row
+    for(GLuint i = 0; i < 4; i++) {
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_INSTANCE_MATRIX + i);
+        glVertexAttribPointer(GLT_ATTRIBUTE_INSTANCE_MATRIX + i, 4, GL_FLOAT, GL_FALSE, sizeof(GLTINSTANCEDATA),
+                              (const GLvoid *)(offsetof(GLTINSTANCEDATA, mTransform) + sizeof(M3DVector4f) * i));
+        glVertexAttribDivisor(GLT_ATTRIBUTE_INSTANCE_MATRIX + i, 1);
+        }
+
+    glEnableVertexAttribArray(GLT_ATTRIBUTE_INSTANCE_COLOR);
+    glVertexAttribPointer(GLT_ATTRIBUTE_INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(GLTINSTANCEDATA),
+                          (const GLvoid *)offsetof(GLTINSTANCEDATA, vColor));
+    glVertexAttribDivisor(GLT_ATTRIBUTE_INSTANCE_COLOR, 1);
+
+    // Same as End(), nothing is left bound for the next batch to trip over
+    pStateCache->BindVertexArray(0);
+    pStateCache->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    uiInstanceVAO = vertexArrayBufferObject;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+// Submit the whole crowd at once
+void GLTriangleBatch::DrawInstanced(GLuint nInstances)
+    {
+    if(nNumIndexes <= 0 || nInstanceCount == 0)
+        return;
+
+    if(nInstances > nInstanceCount)
+        nInstances = nInstanceCount;
+
+    if(uiInstanceVAO != vertexArrayBufferObject)
+        AttachInstanceData();
+
+    GLStateCache::GetStateCache()->BindVertexArray(vertexArrayBufferObject);
+    glDrawElementsInstanced(GL_TRIANGLES, nNumIndexes, indexType, 0, nInstances);
+    }
+
+////////////////////////////////////////////////////////////////////////
+// Mesh files. A GLTMESHHEADER is followed by the indexes, positions, normals,
+// and texture coordinates, each starting on a GLT_MESH_ALIGNMENT boundary
+// (from the start of the file), so the whole thing can be memory mapped and
+// each section handed straight to OpenGL. Vertex data is always stored one
+// attribute after another as floats, whatever layout the batch uses.
+// Files without the header are the original headerless format.
+
+// File positions are 64-bit everywhere, long is only 32 on Windows and
+// scanned meshes can be much bigger than 2GB.
+static inline int SeekFile(FILE *pFile, unsigned long long nOffset, int nOrigin = SEEK_SET)
+    {
+#ifdef _WIN32
+    return _fseeki64(pFile, (__int64)nOffset, nOrigin);
+#else
+    return fseeko(pFile, (off_t)nOffset, nOrigin);
+#endif
+    }
+
+static inline long long TellFile(FILE *pFile)
+    {
+#ifdef _WIN32
+    return _ftelli64(pFile);
+#else
+    return (long long)ftello(pFile);
+#endif
+    }
+
+// Move the file position up to the next aligned offset
+static bool PadFileToAlignment(FILE *pFile)
+    {
+    long long nPos = TellFile(pFile);
+    if(nPos < 0)
+        return false;
+
+    static const GLubyte zeros[GLT_MESH_ALIGNMENT] = { 0 };
+    size_t nPad = (GLT_MESH_ALIGNMENT - (nPos % GLT_MESH_ALIGNMENT)) % GLT_MESH_ALIGNMENT;
+    return fwrite(zeros, 1, nPad, pFile) == nPad;
+    }
+
+////////////////////////////////////////////////////////////////////////
+// Read one attribute back from a buffer object and write it to the file.
+// nStride and nOffset pick the attribute out of an interleaved buffer.
+bool GLTriangleBatch::WriteBufferSection(FILE *pFile, GLuint buffer, size_t nBufferSize, size_t nOffset,
+                                         size_t nStride, size_t nElementSize, GLuint nCount)
+    {
+    // An empty range can't be mapped, and there's nothing to write anyway
+    if(nCount == 0 || nBufferSize == 0)
+        return true;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    const GLubyte *pData = (const GLubyte *)glMapBufferRange(GL_COPY_READ_BUFFER, 0, nBufferSize, GL_MAP_READ_BIT);
+    if(pData == nullptr)
+        return false;
+
+    bool bOK = true;
+    if(nStride == nElementSize)
+        bOK = fwrite(pData + nOffset, nElementSize * nCount, 1, pFile) == 1;
+    else
+        for(GLuint i = 0; i < nCount && bOK; i++)
+            bOK = fwrite(pData + nOffset + i * nStride, nElementSize, 1, pFile) == 1;
+
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return bOK;
+    }
+
+////////////////////////////////////////////////////////////////////////
+// Save the mesh into the already open file stream. Call after End(), the
+// data is read back from the buffer objects.
+bool GLTriangleBatch::SaveMesh(FILE *pFile)
+    {
+    // Compressed attributes can't be turned back into the originals
+    if(!bMadeStuff || nCompression != 0)
+        return false;
+
+    // Non-NULL attribute pointers are our original flag
+    bool bNormals = (pNorms != nullptr);
+    bool bTexCoords = (pTexCoords != nullptr);
+
+    GLTMESHHEADER header;
+    memset(&header, 0, sizeof(header));
+    header.magic = GLT_MESH_MAGIC;
+    header.version = GLT_MESH_VERSION;
+    header.flags = (bNormals ? GLT_MESH_NORMALS : 0) | (bTexCoords ? GLT_MESH_TEXCOORDS : 0);
+    header.indexSize = IndexTypeSize(indexType);
+    header.numIndexes = nNumIndexes;
+    header.numVerts = nNumVerts;
+    header.boundingSphereRadius = boundingSphereRadius;
+    memcpy(header.boundsMin, vBoundsMin, sizeof(M3DVector3f));
+    memcpy(header.boundsMax, vBoundsMax, sizeof(M3DVector3f));
+
+    header.sectionSize[INDEX_DATA] = (unsigned long long)header.indexSize * nNumIndexes;
+    header.sectionSize[VERTEX_DATA] = sizeof(M3DVector3f) * (unsigned long long)nNumVerts;
+    header.sectionSize[NORMAL_DATA] = bNormals ? sizeof(M3DVector3f) * (unsigned long long)nNumVerts : 0;
+    header.sectionSize[TEXTURE_DATA] = bTexCoords ? sizeof(M3DVector2f) * (unsigned long long)nNumVerts : 0;
+
+    // Work out where everything goes
+    long long nStart = TellFile(pFile);
+    if(nStart < 0)
+        return false;
+
+    static const int sectionOrder[4] = { INDEX_DATA, VERTEX_DATA, NORMAL_DATA, TEXTURE_DATA };
+    unsigned long long nOffset = (unsigned long long)nStart + sizeof(GLTMESHHEADER);
+    for(int i = 0; i < 4; i++) {
+        nOffset = (nOffset + GLT_MESH_ALIGNMENT - 1) / GLT_MESH_ALIGNMENT * GLT_MESH_ALIGNMENT;
+        header.sectionOffset[sectionOrder[i]] = nOffset;
+        nOffset += header.sectionSize[sectionOrder[i]];
+        }
+
+    if(fwrite(&header, sizeof(header), 1, pFile) != 1)
+        return false;
+
+    // Where each attribute is in the vertex buffer(s)
+    size_t nVertexStride = sizeof(M3DVector3f);
+    size_t nNormalStride = sizeof(M3DVector3f);
+    size_t nTexStride = sizeof(M3DVector2f);
+    size_t nNormalOffset = 0, nTexOffset = 0;
+    GLuint normalBuffer = bufferObjects[NORMAL_DATA];
+    GLuint texBuffer = bufferObjects[TEXTURE_DATA];
+    if(bInterleaved) {
+        nNormalOffset = sizeof(M3DVector3f);
+        nTexOffset = nNormalOffset + (bNormals ? sizeof(M3DVector3f) : 0);
+        nVertexStride = nNormalStride = nTexStride = nTexOffset + (bTexCoords ? sizeof(M3DVector2f) : 0);
+        normalBuffer = texBuffer = bufferObjects[VERTEX_DATA];
+        }
+
+    bool bOK = PadFileToAlignment(pFile) &&
+               WriteBufferSection(pFile, bufferObjects[INDEX_DATA], header.sectionSize[INDEX_DATA], 0,
+                                  header.indexSize, header.indexSize, nNumIndexes);
+
+    bOK = bOK && PadFileToAlignment(pFile) &&
+          WriteBufferSection(pFile, bufferObjects[VERTEX_DATA], nVertexStride * nNumVerts, 0,
+                             nVertexStride, sizeof(M3DVector3f), nNumVerts);
+
+    if(bNormals)
+        bOK = bOK && PadFileToAlignment(pFile) &&
+              WriteBufferSection(pFile, normalBuffer, nNormalStride * nNumVerts, nNormalOffset,
+                                 nNormalStride, sizeof(M3DVector3f), nNumVerts);
+
+    if(bTexCoords)
+        bOK = bOK && PadFileToAlignment(pFile) &&
+              WriteBufferSection(pFile, texBuffer, nTexStride * nNumVerts, nTexOffset,
+                                 nTexStride, sizeof(M3DVector2f), nNumVerts);
+
+    return bOK;
+    }
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Map part of an open file into memory, read only. The range doesn't need
+// to be page aligned, *ppView and *pnViewSize are what to pass to UnmapFileRange().
+static const GLubyte *MapFileRange(FILE *pFile, unsigned long long nOffset, size_t nSize, void **ppView, size_t *pnViewSize)
+    {
+    if(nSize == 0)
+        return nullptr;
+
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    unsigned long long nStart = nOffset - (nOffset % info.dwAllocationGranularity);
+
+    HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(pFile));
+    HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(hMapping == NULL)
+        return nullptr;
+
+    *pnViewSize = (size_t)(nOffset - nStart) + nSize;
+    *ppView = MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(nStart >> 32), (DWORD)(nStart & 0xFFFFFFFF), *pnViewSize);
+    CloseHandle(hMapping);  // The view keeps the mapping alive
+    if(*ppView == NULL)
+        return nullptr;
+#else
+    long nPageSize = sysconf(_SC_PAGESIZE);
+    unsigned long long nStart = nOffset - (nOffset % (unsigned long long)nPageSize);
+
+    *pnViewSize = (size_t)(nOffset - nStart) + nSize;
+    *ppView = mmap(NULL, *pnViewSize, PROT_READ, MAP_PRIVATE, fileno(pFile), (off_t)nStart);
+    if(*ppView == MAP_FAILED)
+        return nullptr;
+#endif
+
+    return (const GLubyte *)*ppView + (nOffset - nStart);
+    }
+
+static void UnmapFileRange(void *pView, size_t nViewSize)
+    {
+#ifdef _WIN32
+    (void)nViewSize;
+    UnmapViewOfFile(pView);
+#else
+    munmap(pView, nViewSize);
+#endif
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Read the header of a mesh file, in either format, leaving the file where it was.
+// The flags say which attributes will actually be loaded, and the sections that
+// won't be have a size of zero. Old files don't have a bounding box, they are
+// told apart by not having the magic number. *pnEnd is set to the end of the mesh.
+// A header that doesn't agree with itself or with the size of the file is
+// rejected, nothing past the end of the file is ever mapped or read.
+static bool ReadMeshHeader(FILE *pFile, bool bNormals, bool bTexCoords, GLTMESHHEADER *pHeader, unsigned long long *pnEnd)
+    {
+    long long nStart = TellFile(pFile);
+    if(nStart < 0)
+        return false;
+
+    if(SeekFile(pFile, 0, SEEK_END) != 0)
+        return false;
+    long long nEndOfFile = TellFile(pFile);
+    if(nEndOfFile < 0 || SeekFile(pFile, nStart) != 0)
+        return false;
+    unsigned long long nFileSize = (unsigned long long)nEndOfFile;
+
+    if(fread(pHeader, sizeof(GLTMESHHEADER), 1, pFile) != 1 || pHeader->magic != GLT_MESH_MAGIC) {
+        // The old format, everything is one after the other
+        memset(pHeader, 0, sizeof(GLTMESHHEADER));
+        SeekFile(pFile, nStart);
+        if(fread(&pHeader->numIndexes, sizeof(GLuint), 1, pFile) != 1 ||
+           fread(&pHeader->numVerts, sizeof(GLuint), 1, pFile) != 1 ||
+           fread(&pHeader->boundingSphereRadius, sizeof(GLfloat), 1, pFile) != 1)
+            return false;
+
+        unsigned long long nOffset = (unsigned long long)nStart + sizeof(GLuint) * 2 + sizeof(GLfloat);
+        pHeader->indexSize = (pHeader->numVerts > 0x10000) ? sizeof(GLuint) : sizeof(GLushort);
+
+        pHeader->sectionOffset[INDEX_DATA] = nOffset;
+        pHeader->sectionSize[INDEX_DATA] = (unsigned long long)pHeader->indexSize * pHeader->numIndexes;
+        nOffset += pHeader->sectionSize[INDEX_DATA];
+
+        pHeader->sectionOffset[VERTEX_DATA] = nOffset;
+        pHeader->sectionSize[VERTEX_DATA] = sizeof(M3DVector3f) * (unsigned long long)pHeader->numVerts;
+        nOffset += pHeader->sectionSize[VERTEX_DATA];
+
+        // The caller has to know if there are normals and texture coordinates,
+        // and if the file isn't long enough for them, there aren't any.
+        if(bNormals && nOffset + sizeof(M3DVector3f) * (unsigned long long)pHeader->numVerts <= nFileSize) {
+            pHeader->flags |= GLT_MESH_NORMALS;
+            pHeader->sectionOffset[NORMAL_DATA] = nOffset;
+            pHeader->sectionSize[NORMAL_DATA] = sizeof(M3DVector3f) * (unsigned long long)pHeader->numVerts;
+            nOffset += pHeader->sectionSize[NORMAL_DATA];
+            }
+
+        if(bTexCoords && nOffset + sizeof(M3DVector2f) * (unsigned long long)pHeader->numVerts <= nFileSize) {
+            pHeader->flags |= GLT_MESH_TEXCOORDS;
+            pHeader->sectionOffset[TEXTURE_DATA] = nOffset;
+            pHeader->sectionSize[TEXTURE_DATA] = sizeof(M3DVector2f) * (unsigned long long)pHeader->numVerts;
+            }
+        }
+
+    // Something we can use?
+    if(pHeader->version > GLT_MESH_VERSION)
+        return false;
+
+    if(pHeader->indexSize != 1 && pHeader->indexSize != 2 && pHeader->indexSize != 4)
+        return false;
+
+    // Indexes are only ever packed down, never widened
+    if(pHeader->indexSize < IndexTypeSize(IndexTypeForVertexCount(pHeader->numVerts)))
+        return false;
+
+    // Every section has to be exactly as big as the counts say, and the
+    // optional ones are there if and only if the flags say so
+    unsigned long long nVerts = pHeader->numVerts;
+    if(pHeader->sectionSize[INDEX_DATA] != (unsigned long long)pHeader->indexSize * pHeader->numIndexes ||
+       pHeader->sectionSize[VERTEX_DATA] != sizeof(M3DVector3f) * nVerts ||
+       pHeader->sectionSize[NORMAL_DATA] != ((pHeader->flags & GLT_MESH_NORMALS) ? sizeof(M3DVector3f) * nVerts : 0) ||
+       pHeader->sectionSize[TEXTURE_DATA] != ((pHeader->flags & GLT_MESH_TEXCOORDS) ? sizeof(M3DVector2f) * nVerts : 0))
+        return false;
+
+    // And all of it has to be in the file. Even an empty mesh ends after its header.
+    *pnEnd = (unsigned long long)nStart + ((pHeader->magic == GLT_MESH_MAGIC) ? sizeof(GLTMESHHEADER) : sizeof(GLuint) * 2 + sizeof(GLfloat));
+    for(int i = 0; i < 4; i++) {
+        if(pHeader->sectionSize[i] == 0)
+            continue;
+
+        if(pHeader->sectionOffset[i] > nFileSize || pHeader->sectionSize[i] > nFileSize - pHeader->sectionOffset[i])
+            return false;
+
+        if(pHeader->sectionOffset[i] + pHeader->sectionSize[i] > *pnEnd)
+            *pnEnd = pHeader->sectionOffset[i] + pHeader->sectionSize[i];
+        }
+
+    // Drop what the caller doesn't want
+    if(!bNormals) {
+        pHeader->flags &= ~GLT_MESH_NORMALS;
+        pHeader->sectionSize[NORMAL_DATA] = 0;
+        }
+
+    if(!bTexCoords) {
+        pHeader->flags &= ~GLT_MESH_TEXCOORDS;
+        pHeader->sectionSize[TEXTURE_DATA] = 0;
+        }
+
+    SeekFile(pFile, nStart);
+    return true;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Pack nCount indexes from nSrcIndexSize down to nDestIndexSize bytes each, in place
+static void PackIndexes(GLubyte *pIndexData, size_t nCount, GLuint nSrcIndexSize, GLuint nDestIndexSize)
+    {
+    if(nSrcIndexSize == nDestIndexSize)
+        return;
+
+    for(size_t i = 0; i < nCount; i++) {
+        GLuint index = (nSrcIndexSize == sizeof(GLuint)) ? ((GLuint *)pIndexData)[i] : ((GLushort *)pIndexData)[i];
+        if(nDestIndexSize == sizeof(GLubyte))
+            pIndexData[i] = (GLubyte)index;
+        else
+            ((GLushort *)pIndexData)[i] = (GLushort)index;
+        }
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Grow a bounding box to take in some vertices
+static void GrowBounds(const M3DVector3f *pVertData, size_t nCount, GLfloat *pMin, GLfloat *pMax)
+    {
+    for(size_t i = 0; i < nCount; i++)
+        for(int j = 0; j < 3; j++) {
+            if(pVertData[i][j] < pMin[j])
+                pMin[j] = pVertData[i][j];
+            if(pVertData[i][j] > pMax[j])
+                pMax[j] = pVertData[i][j];
+            }
+    }
+
+static void EmptyBounds(GLuint nVerts, GLfloat *pMin, GLfloat *pMax)
+    {
+    for(int j = 0; j < 3; j++) {
+        pMin[j] = (nVerts > 0) ? FLT_MAX : 0.0f;
+        pMax[j] = (nVerts > 0) ? -FLT_MAX : 0.0f;
+        }
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Counts and bounds from a mesh header
+void GLTriangleBatch::SetFromHeader(const GLTMESHHEADER &header)
+    {
+    nCompression = 0;
+    nNumIndexes = header.numIndexes;
+    nNumVerts = header.numVerts;
+    boundingSphereRadius = header.boundingSphereRadius;
+    memcpy(vBoundsMin, header.boundsMin, sizeof(M3DVector3f));
+    memcpy(vBoundsMax, header.boundsMax, sizeof(M3DVector3f));
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Create the buffer objects and vertex array object for a loaded mesh, and
+// leave things just like End() would have.
+void GLTriangleBatch::UploadMesh(const GLvoid *pIndexData, GLuint nIndexSize, const GLvoid *pVertData,
+                                 const GLvoid *pNormData, const GLvoid *pTexData)
+    {
+    FreeBuffers();
+    glGenBuffers(4, bufferObjects);
+    glGenVertexArrays(1, &vertexArrayBufferObject);
+    GLStateCache::GetStateCache()->BindVertexArray(vertexArrayBufferObject);
+
+    bInterleaved = false;
+    UploadPlanar(pVertData, pNormData, pTexData);
+    UploadIndexes(pIndexData, nIndexSize);
+
+    GLStateCache::GetStateCache()->BindVertexArray(0);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    MarkLoaded(pNormData != nullptr, pTexData != nullptr);
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Same flags End() leaves, so the destructor and SaveMesh know what we have
+void GLTriangleBatch::MarkLoaded(bool bNormals, bool bTexCoords)
+    {
+    pVerts = (M3DVector3f*)NOT_VALID_BUT_USED;
+    pNorms = bNormals ? (M3DVector3f*)NOT_VALID_BUT_USED : nullptr;
+    pTexCoords = bTexCoords ? (M3DVector2f*)NOT_VALID_BUT_USED : nullptr;
+    pIndexes = (GLuint*)NOT_VALID_BUT_USED;
+    bMadeStuff = true;
+    bUploading = false;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Load a mesh saved by SaveMesh(). The sections are memory mapped and given
+// straight to glBufferData, no copy is made. If mapping isn't possible, they are
+// read in the usual way.
+bool GLTriangleBatch::LoadMappedMesh(FILE *pFile, const GLTMESHHEADER &header, unsigned long long nEnd)
+    {
+    SetFromHeader(header);
+
+    // One mapping covers all of it. Empty sections can say they are anywhere.
+    unsigned long long nFirst = nEnd;
+    unsigned long long nLast = 0;
+    for(int i = 0; i < 4; i++)
+        if(header.sectionSize[i] != 0) {
+            if(header.sectionOffset[i] < nFirst)
+                nFirst = header.sectionOffset[i];
+            if(header.sectionOffset[i] + header.sectionSize[i] > nLast)
+                nLast = header.sectionOffset[i] + header.sectionSize[i];
+            }
+
+    // An empty mesh is still a mesh, there just isn't anything to map
+    if(nLast == 0) {
+        UploadMesh(nullptr, header.indexSize, nullptr, nullptr, nullptr);
+        SeekFile(pFile, nEnd);
+        return true;
+        }
+
+    void *pView = nullptr;
+    size_t nViewSize = 0;
+    const GLubyte *pMapped = MapFileRange(pFile, nFirst, (size_t)(nLast - nFirst), &pView, &nViewSize);
+
+    const GLubyte *pSections[4] = { nullptr, nullptr, nullptr, nullptr };
+    GLubyte *pRead = nullptr;
+    if(pMapped) {
+        for(int i = 0; i < 4; i++)
+            if(header.sectionSize[i] != 0)
+                pSections[i] = pMapped + (header.sectionOffset[i] - nFirst);
+        }
+    else {
+        // No mapping, read it all in with one read
+        pRead = new GLubyte[(size_t)(nLast - nFirst)];
+        if(SeekFile(pFile, nFirst) != 0 || fread(pRead, (size_t)(nLast - nFirst), 1, pFile) != 1) {
+            delete [] pRead;
+            return false;
+            }
+
+        for(int i = 0; i < 4; i++)
+            if(header.sectionSize[i] != 0)
+                pSections[i] = pRead + (header.sectionOffset[i] - nFirst);
+        }
+
+    UploadMesh(pSections[INDEX_DATA], header.indexSize, pSections[VERTEX_DATA],
+               pSections[NORMAL_DATA], pSections[TEXTURE_DATA]);
+
+    if(pView)
+        UnmapFileRange(pView, nViewSize);
+    delete [] pRead;
+
+    // Leave the file at the end of this mesh, there may be another one
+    SeekFile(pFile, nEnd);
+    return true;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Read a mesh into memory without touching OpenGL, so this can be done on any
+// thread. Hand the result to UploadMeshData(), or to BeginUpload() and UploadChunk()
+// to spread the upload out. Indexes are packed to the size the batch will draw
+// with, and old files get a bounding box. Free it with FreeMeshData().
+bool GLTriangleBatch::ReadMeshData(FILE *pFile, bool bNormals, bool bTexCoords, GLTMESHDATA *pData)
+    {
+    memset(pData, 0, sizeof(GLTMESHDATA));
+
+    unsigned long long nEnd;
+    GLTMESHHEADER &header = pData->header;
+    if(!ReadMeshHeader(pFile, bNormals, bTexCoords, &header, &nEnd))
+        return false;
+
+    for(int i = 0; i < 4; i++) {
+        if(header.sectionSize[i] == 0)
+            continue;
+
+        pData->pSections[i] = new GLubyte[(size_t)header.sectionSize[i]];
+        if(SeekFile(pFile, header.sectionOffset[i]) != 0 ||
+           fread(pData->pSections[i], (size_t)header.sectionSize[i], 1, pFile) != 1) {
+            FreeMeshData(pData);
+            return false;
+            }
+        }
+
+    GLuint nIndexSize = IndexTypeSize(IndexTypeForVertexCount(header.numVerts));
+    PackIndexes(pData->pSections[INDEX_DATA], header.numIndexes, header.indexSize, nIndexSize);
+    header.indexSize = nIndexSize;
+    header.sectionSize[INDEX_DATA] = (unsigned long long)nIndexSize * header.numIndexes;
+
+    // It's a complete header now
+    if(header.magic != GLT_MESH_MAGIC) {
+        EmptyBounds(header.numVerts, header.boundsMin, header.boundsMax);
+        GrowBounds((const M3DVector3f *)pData->pSections[VERTEX_DATA], header.numVerts, header.boundsMin, header.boundsMax);
+        header.magic = GLT_MESH_MAGIC;
+        header.version = GLT_MESH_VERSION;
+        }
+
+    // Leave the file at the end of this mesh, there may be another one
+    SeekFile(pFile, nEnd);
+    return true;
+    }
+
+void GLTriangleBatch::FreeMeshData(GLTMESHDATA *pData)
+    {
+    for(int i = 0; i < 4; i++) {
+        delete [] pData->pSections[i];
+        pData->pSections[i] = nullptr;
+        }
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Upload a mesh read by ReadMeshData() all at once
+void GLTriangleBatch::UploadMeshData(const GLTMESHDATA *pData)
+    {
+#ifdef QT_IS_AVAILABLE
+    initializeOpenGLFunctions();
+#endif
+    SetFromHeader(pData->header);
+    UploadMesh(pData->pSections[INDEX_DATA], pData->header.indexSize, pData->pSections[VERTEX_DATA],
+               pData->pSections[NORMAL_DATA], pData->pSections[TEXTURE_DATA]);
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Or a piece at a time. BeginUpload() creates the empty buffers, then call
+// UploadChunk() until it returns true. Each call copies no more than nMaxBytes.
+// Any mesh the batch had before is gone, and it doesn't draw until it's done.
+void GLTriangleBatch::BeginUpload(GLTMESHDATA *pData)
+    {
+#ifdef QT_IS_AVAILABLE
+    initializeOpenGLFunctions();
+#endif
+    FreeBuffers();
+    bUploading = true;
+
+    const GLTMESHHEADER &header = pData->header;
+    SetFromHeader(header);
+    pData->nUploaded = 0;
+
+    glGenBuffers(4, bufferObjects);
+    glGenVertexArrays(1, &vertexArrayBufferObject);
+    GLStateCache::GetStateCache()->BindVertexArray(vertexArrayBufferObject);
+    bInterleaved = false;
+
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)header.sectionSize[VERTEX_DATA], NULL, GL_STATIC_DRAW);
+    glVertexAttribPointer(GLT_ATTRIBUTE_VERTEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(GLT_ATTRIBUTE_VERTEX);
+
+    if(pData->pSections[NORMAL_DATA]) {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[NORMAL_DATA]);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)header.sectionSize[NORMAL_DATA], NULL, GL_STATIC_DRAW);
+        glVertexAttribPointer(GLT_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_NORMAL);
+        }
+
+    if(pData->pSections[TEXTURE_DATA]) {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[TEXTURE_DATA]);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)header.sectionSize[TEXTURE_DATA], NULL, GL_STATIC_DRAW);
+        glVertexAttribPointer(GLT_ATTRIBUTE_TEXTURE0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_TEXTURE0);
+        }
+
+    // ReadMeshData() already packed these to the right size
+    indexType = IndexTypeForVertexCount(nNumVerts);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects[INDEX_DATA]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)header.sectionSize[INDEX_DATA], NULL, GL_STATIC_DRAW);
+
+    GLStateCache::GetStateCache()->BindVertexArray(0);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+bool GLTriangleBatch::UploadChunk(GLTMESHDATA *pData, size_t nMaxBytes)
+    {
+    // Through the copy target, so no vertex array object is disturbed
+    unsigned long long nPos = pData->nUploaded;
+    for(int i = 0; i < 4; i++) {
+        unsigned long long nSize = pData->header.sectionSize[i];
+        if(nPos >= nSize) {
+            nPos -= nSize;
+            continue;
+            }
+
+        size_t nBytes = (size_t)((nSize - nPos < nMaxBytes) ? (nSize - nPos) : nMaxBytes);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bufferObjects[i]);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)nPos, (GLsizeiptr)nBytes, pData->pSections[i] + nPos);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        pData->nUploaded += nBytes;
+        if(nPos + nBytes < nSize || i < 3)
+            return false;
+        }
+
+    // All there
+    MarkLoaded(pData->pSections[NORMAL_DATA] != nullptr, pData->pSections[TEXTURE_DATA] != nullptr);
+    return true;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Give up on an upload that BeginUpload() started and UploadChunk() hasn't
+// finished. The buffers are deleted and the batch is left empty. Does nothing
+// if there is no upload going on.
+void GLTriangleBatch::CancelUpload(void)
+    {
+    if(!bUploading)
+        return;
+
+    FreeBuffers();
+    nNumIndexes = 0;
+    nNumVerts = 0;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Load a mesh into this batch, given the existing and already opened file stream.
+// Files written by SaveMesh() say what they contain. For the old headerless files,
+// you must have verts, but normals and vetexes are optional. You need to know
+// ahead of time which are in the file.
+bool GLTriangleBatch::LoadMesh(FILE *pFile, bool bNormals, bool bTexCoords)
+    {
+// In case this is called first (does no harm to call multiple times)
+#ifdef QT_IS_AVAILABLE
+    initializeOpenGLFunctions();
+#endif
+    GLTMESHHEADER header;
+    unsigned long long nEnd;
+    if(!ReadMeshHeader(pFile, bNormals, bTexCoords, &header, &nEnd))
+        return false;
+
+    if(header.magic == GLT_MESH_MAGIC)
+        return LoadMappedMesh(pFile, header, nEnd);
+
+    // Nope, the old format. Read it all in.
+    GLTMESHDATA data;
+    if(!ReadMeshData(pFile, bNormals, bTexCoords, &data))
+        return false;
+
+    UploadMeshData(&data);
+    FreeMeshData(&data);
+    return true;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Copy nSize bytes from the current file position into the buffer bound to
+// target, nChunkSize bytes at a time through pChunk. Index sections are packed
+// down from nSrcIndexSize to nDestIndexSize bytes per index as they go (pass 0
+// for other data). If pMin and pMax aren't NULL, the data is positions and the
+// bounding box is grown to fit them.
+bool GLTriangleBatch::StreamSection(FILE *pFile, GLenum target, unsigned long long nSize, GLubyte *pChunk, size_t nChunkSize,
+                                    GLuint nSrcIndexSize, GLuint nDestIndexSize, GLfloat *pMin, GLfloat *pMax)
+    {
+    unsigned long long nDestSize = nSize;
+    if(nSrcIndexSize != 0)
+        nDestSize = nSize / nSrcIndexSize * nDestIndexSize;
+
+    glBufferData(target, (GLsizeiptr)nDestSize, NULL, GL_STATIC_DRAW);
+
+    unsigned long long nDestOffset = 0;
+    for(unsigned long long nRead = 0; nRead < nSize; ) {
+        size_t nThisChunk = (size_t)((nSize - nRead < nChunkSize) ? (nSize - nRead) : nChunkSize);
+        if(fread(pChunk, nThisChunk, 1, pFile) != 1)
+            return false;
+
+        nRead += nThisChunk;
+        size_t nUpload = nThisChunk;
+
+        // Never bigger than the file's indexes, so this can be done in place
+        if(nSrcIndexSize != 0) {
+            PackIndexes(pChunk, nThisChunk / nSrcIndexSize, nSrcIndexSize, nDestIndexSize);
+            nUpload = nThisChunk / nSrcIndexSize * nDestIndexSize;
+            }
+
+        if(pMin != nullptr)
+            GrowBounds((const M3DVector3f *)pChunk, nThisChunk / sizeof(M3DVector3f), pMin, pMax);
+
+        glBufferSubData(target, (GLintptr)nDestOffset, (GLsizeiptr)nUpload, pChunk);
+        nDestOffset += nUpload;
+        }
+
+    return true;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Load a mesh without ever holding more than nChunkSize bytes of it in memory.
+// Each attribute is created empty, then filled in a chunk at a time. Use this for
+// meshes too big to have two copies around at once. Reads the same files as LoadMesh().
+bool GLTriangleBatch::LoadMeshStreamed(FILE *pFile, bool bNormals, bool bTexCoords, GLuint nChunkSize)
+    {
+#ifdef QT_IS_AVAILABLE
+    initializeOpenGLFunctions();
+#endif
+    // Whole vertices and indexes in every chunk
+    nChunkSize -= nChunkSize % GLT_MESH_CHUNK_GRANULARITY;
+    if(nChunkSize == 0)
+        nChunkSize = GLT_MESH_CHUNK_GRANULARITY;
+
+    // Where everything is
+    GLTMESHHEADER header;
+    unsigned long long nEnd;
+    if(!ReadMeshHeader(pFile, bNormals, bTexCoords, &header, &nEnd))
+        return false;
+
+    bNormals = (header.flags & GLT_MESH_NORMALS) != 0;
+    bTexCoords = (header.flags & GLT_MESH_TEXCOORDS) != 0;
+
+    // Only the old format needs the bounding box worked out
+    GLfloat *pMin = nullptr, *pMax = nullptr;
+    if(header.magic != GLT_MESH_MAGIC) {
+        EmptyBounds(header.numVerts, header.boundsMin, header.boundsMax);
+        pMin = vBoundsMin;
+        pMax = vBoundsMax;
+        }
+    // Out with the old mesh, if there was one. From here on a failure
+    // leaves the batch empty.
+    FreeBuffers();
+    bUploading = true;
+    SetFromHeader(header);
+
+    glGenBuffers(4, bufferObjects);
+    glGenVertexArrays(1, &vertexArrayBufferObject);
+    GLStateCache::GetStateCache()->BindVertexArray(vertexArrayBufferObject);
+    bInterleaved = false;
+
+    // The only memory we need
+    GLubyte *pChunk = new GLubyte[nChunkSize];
+
+    // Vertex data
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[VERTEX_DATA]);
+    bool bOK = SeekFile(pFile, header.sectionOffset[VERTEX_DATA]) == 0 &&
+               StreamSection(pFile, GL_ARRAY_BUFFER, header.sectionSize[VERTEX_DATA], pChunk, nChunkSize, 0, 0, pMin, pMax);
+    glVertexAttribPointer(GLT_ATTRIBUTE_VERTEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(GLT_ATTRIBUTE_VERTEX);
+
+    // Normal data
+    if(bNormals) {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[NORMAL_DATA]);
+        bOK = bOK && SeekFile(pFile, header.sectionOffset[NORMAL_DATA]) == 0 &&
+              StreamSection(pFile, GL_ARRAY_BUFFER, header.sectionSize[NORMAL_DATA], pChunk, nChunkSize, 0, 0, nullptr, nullptr);
+        glVertexAttribPointer(GLT_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_NORMAL);
+        }
+
+    // Texture coordinates
+    if(bTexCoords) {
+        GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, bufferObjects[TEXTURE_DATA]);
+        bOK = bOK && SeekFile(pFile, header.sectionOffset[TEXTURE_DATA]) == 0 &&
+              StreamSection(pFile, GL_ARRAY_BUFFER, header.sectionSize[TEXTURE_DATA], pChunk, nChunkSize, 0, 0, nullptr, nullptr);
+        glVertexAttribPointer(GLT_ATTRIBUTE_TEXTURE0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(GLT_ATTRIBUTE_TEXTURE0);
+        }
+
+    // Indexes, the element buffer binding is part of the vertex array object
+    indexType = IndexTypeForVertexCount(nNumVerts);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects[INDEX_DATA]);
+    bOK = bOK && SeekFile(pFile, header.sectionOffset[INDEX_DATA]) == 0 &&
+          StreamSection(pFile, GL_ELEMENT_ARRAY_BUFFER, header.sectionSize[INDEX_DATA], pChunk, nChunkSize,
+                        header.indexSize, IndexTypeSize(indexType), nullptr, nullptr);
+
+    GLStateCache::GetStateCache()->BindVertexArray(0);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLStateCache::GetStateCache()->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    delete [] pChunk;
+
+    // Don't leave a half loaded batch around that says it's ready
+    if(!bOK) {
+        CancelUpload();
+        return false;
+        }
+
+    MarkLoaded(bNormals, bTexCoords);
+
+    // Leave the file at the end of this mesh, there may be another one
+    SeekFile(pFile, nEnd);
+    return true;
+    }
+
+
+bool GLTriangleBatch::SaveMesh(const char *szFileName)
+	{
+	FILE *pFile;
+	pFile = fopen(szFileName, "wb");
+	if(pFile == NULL)
+		return false;
+        
+    bool bOK = SaveMesh(pFile);
+		
+	fclose(pFile);
+	return bOK;
+	}
+
+
+bool GLTriangleBatch::LoadMesh(const char *szFileName, bool bNormals, bool bTexCoords)
+	{
+	FILE *pFile = fopen(szFileName, "rb");
+	if(pFile == NULL)
+		return false;
+
+    bool bOK = LoadMesh(pFile, bNormals, bTexCoords);
+
+    fclose(pFile);
+
+	return bOK;
+	}
+
+
+bool GLTriangleBatch::LoadMeshStreamed(const char *szFileName, bool bNormals, bool bTexCoords, GLuint nChunkSize)
+	{
+	FILE *pFile = fopen(szFileName, "rb");
+	if(pFile == NULL)
+		return false;
+
+    bool bOK = LoadMeshStreamed(pFile, bNormals, bTexCoords, nChunkSize);
+
+    fclose(pFile);
+
+	return bOK;
+	}
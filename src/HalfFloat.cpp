@@ -1,92 +1,354 @@
-/*
- *  HalfFloat.cpp
- *  
- *
- *  Created by Richard Wright on 12/6/10.
- *  Copyright 2010-2023 Starstone Software Systems, Inc. All rights reserved.
- *
- */
-
-#include "HalfFloat.h"
-
-
-hfloat convertFloatToHFloat(float *f) {
-    unsigned int x = *(unsigned int *)f; 
-    unsigned int sign = (unsigned short)(x >> 31); 
-    unsigned int mantissa; 
-    unsigned int exp; 
-    hfloat hf;
-    
-    // get mantissa 
-    mantissa = x & ((1 << 23) - 1); 
-    
-    // get exponent bits 
-    exp = x & FLOAT_MAX_BIASED_EXP; 
-    if (exp >= HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP) {
-        // check if the original single precision float number is a NaN 
-        if (mantissa && (exp == FLOAT_MAX_BIASED_EXP)) {
-        } else {
-            // we have a single precision NaN 
-            mantissa = (1 << 23) - 1;
-            // 16-bit half-float representation stores number as Inf mantissa = 0;
-        } hf = (((hfloat)sign) << 15) | (hfloat)(HALF_FLOAT_MAX_BIASED_EXP) |(hfloat)(mantissa >> 13);
-    } // check if exponent is <= -15 
-    else if (exp <= HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP) {
-        exp = (HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP) >> 23;
-        mantissa >>= (14 + exp);
-        
-        hf = (((hfloat)sign) << 15) | (hfloat)(mantissa);
-    }
-    else {
-        // store a denorm half-float value or zero exp = (HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP - exp) >> 23; mantissa >>= (14 + exp);
-        hf = (((hfloat)sign) << 15) | (hfloat)((exp - HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP) >> 13) | (hfloat)(mantissa >> 13);
-    } 
-    return hf;
-}
-
-
-
-float convertHFloatToFloat(hfloat hf) {
-    unsigned int sign = (unsigned int)(hf >> 15); 
-    unsigned int mantissa = (unsigned int)(hf & ((1 << 10) - 1)); 
-    unsigned int exp = (unsigned int)(hf & HALF_FLOAT_MAX_BIASED_EXP); 
-    unsigned int f;
-    
-    if (exp == HALF_FLOAT_MAX_BIASED_EXP) {
-        // we have a half-float NaN or Inf 
-        // half-float NaNs will be converted to a single precision NaN 
-        // half-float Infs will be converted to a single precision Inf 
-        exp = FLOAT_MAX_BIASED_EXP; 
-        if (mantissa)
-            mantissa = (1 << 23) - 1; // set all bits to indicate a NaN
-    } 
-    else if (exp == 0x0) 
-    {
-        // convert half-float zero/denorm to single precision value 
-        if (mantissa) {
-            mantissa <<= 1; 
-            exp = HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP; 
-            // check for leading 1 in denorm mantissa 
-            while ((mantissa & (1 << 10)) == 0) 
-            {
-                // for every leading 0, decrement single precision exponent by 1 
-                // and shift half-float mantissa value to the left 
-                mantissa <<= 1; 
-                exp -= (1 << 23);
-            } 
-            // clamp the mantissa to 10-bits 
-            mantissa &= ((1 << 10) - 1); 
-            // shift left to generate single-precision mantissa of 23-bits
-            mantissa <<= 13;
-        }
-    }
-    else {
-        // shift left to generate single-precision mantisa of 23-bits
-        mantissa <<= 13;
-        // generte single precision biased exponent value
-        exp = (exp << 13) + HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
-    }
-    
-    f = (sign << 31) | exp | mantissa; 
-    return *((float *)&f);
-}
+/*
+ *  HalfFloat.cpp
+ *  
+ *
+ *  Created by Richard Wright on 12/6/10.
+ *  Copyright 2010-2023 Starstone Software Systems, Inc. All rights reserved.
+ *
+ */
+
+#include "HalfFloat.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Single value conversion is table driven (Jeroen van der Zijp's "Fast Half
+// Float Conversions"). With C++14 the compiler builds the tables. C++11
+// can't run loops in a constexpr constructor, so there they are built the
+// first time they are used. Either way they are ready before anyone can
+// read them, even another file's static initializers.
+//
+// float -> half: the sign and exponent (top 9 bits) pick a base value and
+// how far to shift the mantissa down. Too small is zero, too big is Inf,
+// and denorms come out of the shift. Truncates.
+//
+// half -> float: the mantissa is looked up (denorms come pre-normalized from
+// the first half of the table), and the exponent picks what to add to it.
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#define HFLOAT_CONSTEXPR_TABLES
+#define HFLOAT_CONSTEXPR constexpr
+#else
+#define HFLOAT_CONSTEXPR
+#endif
+
+struct HFLOATTABLES {
+    unsigned short base[512];
+    unsigned char  shift[512];
+    unsigned int   mantissa[2048];
+    unsigned int   exponent[64];
+
+    HFLOAT_CONSTEXPR HFLOATTABLES() : base(), shift(), mantissa(), exponent() {
+        for (int i = 0; i < 256; i++) {
+            int e = i - 127;
+            unsigned short b = 0;
+            unsigned char sh = 24;
+            if (e < -24) {              // too small, zero
+                b = 0x0000;
+                sh = 24;
+            }
+            else if (e < -14) {         // denorm
+                b = (unsigned short)(0x0400 >> (-e - 14));
+                sh = (unsigned char)(-e - 1);
+            }
+            else if (e <= 15) {         // normal
+                b = (unsigned short)((e + 15) << 10);
+                sh = 13;
+            }
+            else if (e < 128) {         // too big, Inf
+                b = 0x7c00;
+                sh = 24;
+            }
+            else {                      // Inf and NaN
+                b = 0x7c00;
+                sh = 13;
+            }
+            base[i] = b;
+            base[i | 0x100] = (unsigned short)(b | 0x8000);
+            shift[i] = sh;
+            shift[i | 0x100] = sh;
+        }
+
+        // Denorms, normalized
+        mantissa[0] = 0;
+        for (unsigned int i = 1; i < 1024; i++) {
+            unsigned int m = i << 13;
+            unsigned int e = 0;
+            while ((m & 0x00800000) == 0) {
+                e -= 0x00800000;
+                m <<= 1;
+            }
+            m &= ~0x00800000U;
+            e += HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP + 0x00800000;
+            mantissa[i] = m | e;
+        }
+        for (unsigned int i = 1024; i < 2048; i++)
+            mantissa[i] = HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP + ((i - 1024) << 13);
+
+        for (unsigned int i = 1; i < 31; i++) {
+            exponent[i] = i << 23;
+            exponent[i + 32] = 0x80000000 | (i << 23);
+        }
+        exponent[0] = 0;
+        exponent[31] = HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP;
+        exponent[32] = 0x80000000;
+        exponent[63] = 0x80000000 | HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP;
+    }
+};
+
+#ifdef HFLOAT_CONSTEXPR_TABLES
+static constexpr HFLOATTABLES hfTables;
+
+static inline const HFLOATTABLES &HFloatTables(void) {
+    return hfTables;
+}
+#else
+static inline const HFLOATTABLES &HFloatTables(void) {
+    static const HFLOATTABLES hfTables;
+    return hfTables;
+}
+#endif
+
+
+hfloat convertFloatToHFloat(float *f) {
+    unsigned int x;
+    memcpy(&x, f, sizeof(x));
+    
+    const HFLOATTABLES &tables = HFloatTables();
+    unsigned int i = x >> 23;
+    hfloat hf = (hfloat)(tables.base[i] + ((x & 0x007fffff) >> tables.shift[i]));
+    
+    // NaN's keep every mantissa bit set, so they don't turn into Inf
+    return hf | (hfloat)(((x & 0x7fffffff) > FLOAT_MAX_BIASED_EXP) * 0x03ff);
+}
+
+
+
+float convertHFloatToFloat(hfloat hf) {
+    const HFLOATTABLES &tables = HFloatTables();
+    unsigned int e = hf >> 10;
+    unsigned int x = tables.mantissa[(((hf & 0x7c00) != 0) << 10) + (hf & 0x03ff)] + tables.exponent[e];
+    
+    // Same for NaN's this way
+    x |= ((unsigned int)((hf & 0x7fff) > HALF_FLOAT_MAX_BIASED_EXP)) * 0x007fffff;
+    
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Bulk conversion. There are three versions of each, picked the first time
+// they are called: F16C (8 at a time), SSE2 (4 at a time), and plain C. The
+// SSE2 and C versions do the same bit tricks, no branches and no loops over
+// denormals, and give the same answers as the F16C instructions.
+
+// float -> half, round to nearest even
+static inline hfloat floatToHFloatRTNE(unsigned int x) {
+    unsigned int sign = x & 0x80000000;
+    x ^= sign;
+    
+    hfloat hf;
+    if (x >= ((127 + 16) << 23)) {
+        // too big, Inf, or NaN (NaN's stay NaN's)
+        hf = (x > FLOAT_MAX_BIASED_EXP) ? (hfloat)(0x7e00 | ((x >> 13) & 0x3ff)) : (hfloat)HALF_FLOAT_MAX_BIASED_EXP;
+    }
+    else if (x < ((127 - 14) << 23)) {
+        // denorm or zero. Adding this lines the mantissa bits up where the half-float
+        // denorm goes, and the floating point add does the rounding for us.
+        const unsigned int denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+        float f, magic;
+        memcpy(&f, &x, sizeof(f));
+        memcpy(&magic, &denormMagic, sizeof(magic));
+        f += magic;
+        memcpy(&x, &f, sizeof(x));
+        hf = (hfloat)(x - denormMagic);
+    }
+    else {
+        // rebias the exponent, and round half to even
+        unsigned int mantOdd = (x >> 13) & 1;
+        x += ((unsigned int)(15 - 127) << 23) + 0xfff + mantOdd;
+        hf = (hfloat)(x >> 13);
+    }
+    
+    return hf | (hfloat)(sign >> 16);
+}
+
+// half -> float. Denorms are scaled into place with one multiply.
+static inline unsigned int hfloatToFloatBits(hfloat hf) {
+    const unsigned int magicBits = (254 - 15) << 23;
+    unsigned int expmant = hf & 0x7fff;
+    unsigned int shifted = expmant << 13;
+    
+    float f, magic;
+    memcpy(&f, &shifted, sizeof(f));
+    memcpy(&magic, &magicBits, sizeof(magic));
+    f *= magic;
+    
+    unsigned int x;
+    memcpy(&x, &f, sizeof(x));
+    if (expmant >= HALF_FLOAT_MAX_BIASED_EXP)
+        x |= FLOAT_MAX_BIASED_EXP;      // Inf or NaN
+    if (expmant > HALF_FLOAT_MAX_BIASED_EXP)
+        x |= 1 << 22;                   // NaN's come out quiet, like F16C
+    
+    return x | ((unsigned int)(hf & 0x8000) << 16);
+}
+
+static void floatToHFloatC(const float *pSrc, hfloat *pDst, size_t nCount) {
+    for (size_t i = 0; i < nCount; i++) {
+        unsigned int x;
+        memcpy(&x, &pSrc[i], sizeof(x));
+        pDst[i] = floatToHFloatRTNE(x);
+    }
+}
+
+static void hfloatToFloatC(const hfloat *pSrc, float *pDst, size_t nCount) {
+    for (size_t i = 0; i < nCount; i++) {
+        unsigned int x = hfloatToFloatBits(pSrc[i]);
+        memcpy(&pDst[i], &x, sizeof(x));
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+#ifdef _MSC_VER
+#define GLT_TARGET_F16C
+#else
+#define GLT_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+
+// Same as floatToHFloatRTNE(), four at a time
+static void floatToHFloatSSE2(const float *pSrc, hfloat *pDst, size_t nCount) {
+    const __m128i signMask = _mm_set1_epi32((int)0x80000000);
+    const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i f32Inf = _mm_set1_epi32((int)FLOAT_MAX_BIASED_EXP);
+    const __m128i normMin = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i rebias = _mm_set1_epi32((int)((unsigned int)(15 - 127) << 23) + 0xfff);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i infOut = _mm_set1_epi32((int)HALF_FLOAT_MAX_BIASED_EXP);
+    const __m128i nanOut = _mm_set1_epi32(0x7e00);
+    const __m128i mantMask = _mm_set1_epi32(0x3ff);
+    
+    size_t i = 0;
+    for (; i + 4 <= nCount; i += 4) {
+        __m128i x = _mm_castps_si128(_mm_loadu_ps(pSrc + i));
+        __m128i sign = _mm_and_si128(x, signMask);
+        x = _mm_xor_si128(x, sign);
+        
+        // Everything is signed compares, fine since the sign is gone
+        __m128i bTooBig = _mm_cmplt_epi32(_mm_sub_epi32(f16Max, one), x);
+        __m128i bNaN = _mm_cmpgt_epi32(x, f32Inf);
+        __m128i bDenorm = _mm_cmplt_epi32(x, normMin);
+        
+        __m128i special = _mm_or_si128(_mm_andnot_si128(bNaN, infOut),
+                                       _mm_and_si128(bNaN, _mm_or_si128(nanOut, _mm_and_si128(_mm_srli_epi32(x, 13), mantMask))));
+        
+        __m128i denorm = _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(denormMagic)));
+        denorm = _mm_sub_epi32(denorm, denormMagic);
+        
+        __m128i mantOdd = _mm_and_si128(_mm_srli_epi32(x, 13), one);
+        __m128i norm = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, rebias), mantOdd), 13);
+        
+        __m128i result = _mm_or_si128(_mm_and_si128(bDenorm, denorm), _mm_andnot_si128(bDenorm, norm));
+        result = _mm_or_si128(_mm_and_si128(bTooBig, special), _mm_andnot_si128(bTooBig, result));
+        result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+        
+        // Sign extend so the saturating pack leaves the bits alone
+        result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+        _mm_storel_epi64((__m128i *)(pDst + i), _mm_packs_epi32(result, result));
+    }
+    
+    floatToHFloatC(pSrc + i, pDst + i, nCount - i);
+}
+
+// Same as hfloatToFloatBits(), four at a time
+static void hfloatToFloatSSE2(const hfloat *pSrc, float *pDst, size_t nCount) {
+    const __m128i expmantMask = _mm_set1_epi32(0x7fff);
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128i wasInfNaN = _mm_set1_epi32(HALF_FLOAT_MAX_BIASED_EXP - 1);
+    const __m128i expInfNaN = _mm_set1_epi32((int)FLOAT_MAX_BIASED_EXP);
+    const __m128i infHalf = _mm_set1_epi32(HALF_FLOAT_MAX_BIASED_EXP);
+    const __m128i quietBit = _mm_set1_epi32(1 << 22);
+    
+    size_t i = 0;
+    for (; i + 4 <= nCount; i += 4) {
+        __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)(pSrc + i)), _mm_setzero_si128());
+        __m128i expmant = _mm_and_si128(h, expmantMask);
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expmant), 16);
+        
+        __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), magic);
+        __m128i infNaN = _mm_and_si128(_mm_cmpgt_epi32(expmant, wasInfNaN), expInfNaN);
+        infNaN = _mm_or_si128(infNaN, _mm_and_si128(_mm_cmpgt_epi32(expmant, infHalf), quietBit));
+        
+        __m128i result = _mm_or_si128(_mm_or_si128(_mm_castps_si128(scaled), infNaN), sign);
+        _mm_storeu_ps(pDst + i, _mm_castsi128_ps(result));
+    }
+    
+    hfloatToFloatC(pSrc + i, pDst + i, nCount - i);
+}
+
+GLT_TARGET_F16C static void floatToHFloatF16C(const float *pSrc, hfloat *pDst, size_t nCount) {
+    size_t i = 0;
+    for (; i + 8 <= nCount; i += 8)
+        _mm_storeu_si128((__m128i *)(pDst + i), _mm256_cvtps_ph(_mm256_loadu_ps(pSrc + i), _MM_FROUND_TO_NEAREST_INT));
+    
+    floatToHFloatC(pSrc + i, pDst + i, nCount - i);
+}
+
+GLT_TARGET_F16C static void hfloatToFloatF16C(const hfloat *pSrc, float *pDst, size_t nCount) {
+    size_t i = 0;
+    for (; i + 8 <= nCount; i += 8)
+        _mm256_storeu_ps(pDst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(pSrc + i))));
+    
+    hfloatToFloatC(pSrc + i, pDst + i, nCount - i);
+}
+
+// F16C is VEX encoded, so the OS has to save the AVX registers too
+static bool hasF16C(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool bOSXSave = (info[2] & (1 << 27)) != 0;
+    bool bAVX = (info[2] & (1 << 28)) != 0;
+    bool bF16C = (info[2] & (1 << 29)) != 0;
+    return bOSXSave && bAVX && bF16C && ((_xgetbv(0) & 6) == 6);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+}
+
+typedef void (*FLOATTOHFLOATFUNC)(const float *, hfloat *, size_t);
+typedef void (*HFLOATTOFLOATFUNC)(const hfloat *, float *, size_t);
+
+void convertFloatToHFloatN(const float *pSrc, hfloat *pDst, size_t nCount) {
+    static const FLOATTOHFLOATFUNC pConvert = hasF16C() ? floatToHFloatF16C : floatToHFloatSSE2;
+    pConvert(pSrc, pDst, nCount);
+}
+
+void convertHFloatToFloatN(const hfloat *pSrc, float *pDst, size_t nCount) {
+    static const HFLOATTOFLOATFUNC pConvert = hasF16C() ? hfloatToFloatF16C : hfloatToFloatSSE2;
+    pConvert(pSrc, pDst, nCount);
+}
+
+#else
+
+void convertFloatToHFloatN(const float *pSrc, hfloat *pDst, size_t nCount) {
+    floatToHFloatC(pSrc, pDst, nCount);
+}
+
+void convertHFloatToFloatN(const hfloat *pSrc, float *pDst, size_t nCount) {
+    hfloatToFloatC(pSrc, pDst, nCount);
+}
+
+#endif
@@ -0,0 +1,134 @@
+// HalfFloatCheck.cpp
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Checks convertFloatToHFloat() and convertHFloatToFloat() against the
+// versions they replaced (HalfFloatReference.h), over every half and every
+// float bit pattern. Takes a few seconds.
+//
+// half -> float must match exactly. float -> half differs on purpose for
+// three kinds of input, which are counted but are not failures:
+//   tiny      exponents -24 to -15 were flushed to zero, they are denormals now
+//   overflow  too big and +-Inf gave 0x7fff (a NaN), they give Inf now
+//   NaN       NaN's kept their top mantissa bits, they are all 0x7fff now
+// Anything else that differs is a failure, and so is the exit code.
+
+#include "HalfFloat.h"
+#include "HalfFloatReference.h"
+
+#include <stdio.h>
+
+enum { CHECK_TINY = 0, CHECK_OVERFLOW, CHECK_NAN, CHECK_OTHER, CHECK_LAST };
+
+///////////////////////////////////////////////////////////////////////////////
+static int Classify(unsigned int x)
+    {
+    unsigned int exp = (x & FLOAT_MAX_BIASED_EXP) >> 23;
+    unsigned int mantissa = x & 0x007fffff;
+
+    if(exp >= 127 - 24 && exp <= 127 - 15)
+        return CHECK_TINY;
+
+    if(exp == 255 && mantissa != 0)
+        return CHECK_NAN;
+
+    if(exp >= 127 + 16)
+        return CHECK_OVERFLOW;
+
+    return CHECK_OTHER;
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void)
+    {
+    static const char *szKinds[CHECK_LAST] = { "tiny", "overflow", "NaN", "other" };
+    bool bFailed = false;
+
+    // Every half
+    unsigned int nHalfMismatches = 0;
+    for(unsigned int h = 0; h < 0x10000; h++)
+        {
+        float fNew = convertHFloatToFloat((hfloat)h);
+        float fOld = referenceHFloatToFloat((hfloat)h);
+        if(memcmp(&fNew, &fOld, sizeof(float)) != 0)
+            {
+            if(nHalfMismatches == 0)
+                {
+                unsigned int xNew, xOld;
+                memcpy(&xNew, &fNew, sizeof(xNew));
+                memcpy(&xOld, &fOld, sizeof(xOld));
+                printf("half 0x%04x: 0x%08x, was 0x%08x\n", h, xNew, xOld);
+                }
+            nHalfMismatches++;
+            }
+        }
+
+    printf("half -> float: 65536 checked, %u differ\n", nHalfMismatches);
+    if(nHalfMismatches != 0)
+        bFailed = true;
+
+    // Every float
+    unsigned long long nCounts[CHECK_LAST] = {};
+    unsigned int nExample[CHECK_LAST][3] = {};
+    unsigned int x = 0;
+    do  {
+        float f;
+        memcpy(&f, &x, sizeof(f));
+
+        hfloat hfNew = convertFloatToHFloat(&f);
+        hfloat hfOld = referenceFloatToHFloat(&f);
+        if(hfNew != hfOld)
+            {
+            int nKind = Classify(x);
+            if(nCounts[nKind]++ == 0)
+                {
+                nExample[nKind][0] = x;
+                nExample[nKind][1] = hfNew;
+                nExample[nKind][2] = hfOld;
+                }
+            }
+
+        x++;
+        } while(x != 0);
+
+    unsigned long long nTotal = 0;
+    for(int k = 0; k < CHECK_LAST; k++)
+        nTotal += nCounts[k];
+
+    printf("float -> half: 4294967296 checked, %llu differ\n", nTotal);
+    for(int k = 0; k < CHECK_LAST; k++)
+        {
+        printf("  %-9s %11llu", szKinds[k], nCounts[k]);
+        if(nCounts[k] != 0)
+            printf("   e.g. 0x%08x: 0x%04x, was 0x%04x", nExample[k][0], nExample[k][1], nExample[k][2]);
+        printf("\n");
+        }
+
+    if(nCounts[CHECK_OTHER] != 0)
+        bFailed = true;
+
+    printf(bFailed ? "FAILED\n" : "OK\n");
+    return bFailed ? 1 : 0;
+    }
@@ -0,0 +1,106 @@
+// HalfFloatReference.h
+/*
+Copyright (c) 2009-2023, Richard S. Wright Jr.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+
+Neither the name of Richard S. Wright Jr. nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// The single value half float conversions as they were before they became
+// table driven, kept to check the tables against and to time them. The
+// float -> half side has one change: for exponents of -15 and below it
+// shifted the mantissa right by 126 bits, which C++ leaves undefined. On
+// x86 that left nothing, a signed zero, and so does this.
+
+#ifndef __GLT_HALF_FLOAT_REFERENCE
+#define __GLT_HALF_FLOAT_REFERENCE
+
+#include "HalfFloat.h"
+#include <string.h>
+
+static inline hfloat referenceFloatToHFloat(const float *f)
+    {
+    unsigned int x;
+    memcpy(&x, f, sizeof(x));
+    unsigned int sign = x >> 31;
+    unsigned int mantissa = x & ((1 << 23) - 1);
+    unsigned int exp = x & FLOAT_MAX_BIASED_EXP;
+    hfloat hf;
+
+    if(exp >= HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP)
+        {
+        // NaN's keep their top mantissa bits. Anything else, too big or Inf,
+        // gets every mantissa bit set, 0x7fff.
+        if(!(mantissa && exp == FLOAT_MAX_BIASED_EXP))
+            mantissa = (1 << 23) - 1;
+
+        hf = (hfloat)((sign << 15) | HALF_FLOAT_MAX_BIASED_EXP | (mantissa >> 13));
+        }
+    else if(exp <= HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP)
+        hf = (hfloat)(sign << 15);
+    else
+        hf = (hfloat)((sign << 15) | ((exp - HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP) >> 13) | (mantissa >> 13));
+
+    return hf;
+    }
+
+static inline float referenceHFloatToFloat(hfloat hf)
+    {
+    unsigned int sign = (unsigned int)(hf >> 15);
+    unsigned int mantissa = (unsigned int)(hf & ((1 << 10) - 1));
+    unsigned int exp = (unsigned int)(hf & HALF_FLOAT_MAX_BIASED_EXP);
+
+    if(exp == HALF_FLOAT_MAX_BIASED_EXP)
+        {
+        // NaN or Inf, NaN's get every mantissa bit set
+        exp = FLOAT_MAX_BIASED_EXP;
+        if(mantissa)
+            mantissa = (1 << 23) - 1;
+        }
+    else if(exp == 0x0)
+        {
+        // Zero or denorm, normalized one bit at a time
+        if(mantissa)
+            {
+            mantissa <<= 1;
+            exp = HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
+            while((mantissa & (1 << 10)) == 0)
+                {
+                mantissa <<= 1;
+                exp -= (1 << 23);
+                }
+            mantissa &= ((1 << 10) - 1);
+            mantissa <<= 13;
+            }
+        }
+    else
+        {
+        mantissa <<= 13;
+        exp = (exp << 13) + HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
+        }
+
+    unsigned int x = (sign << 31) | exp | mantissa;
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+    }
+
+#endif
@@ -0,0 +1,15 @@
+# GLTools checks
+# halffloatcheck compares the half float conversions with the versions they
+# replaced, over every input. It needs no OpenGL and no Qt.
+
+TEMPLATE = app
+TARGET = halffloatcheck
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += $$PWD/../include
+
+HEADERS += HalfFloatReference.h
+
+SOURCES += HalfFloatCheck.cpp \
+           $$PWD/../src/HalfFloat.cpp